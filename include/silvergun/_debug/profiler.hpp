@@ -0,0 +1,179 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_PROFILER_HPP)
+#define SLV_PROFILER_HPP
+
+#include <string>
+#include <map>
+#include <array>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace slv {
+
+namespace mgr {
+  class systems;
+}
+
+/*!
+ * \class system_timing
+ * \brief Run times of one system.  All times are in microseconds.
+ */
+class system_timing final {
+  friend class profiler;
+
+  public:
+    //!  Number of recent runs used for the rolling average.
+    inline static constexpr std::size_t window_size = 120;
+    //!  Number of histogram buckets.  Each bucket is a quarter power of two wider than the last.
+    inline static constexpr std::size_t bucket_count = 64;
+
+  private:
+    //  Histogram bucket for a time.
+    static std::size_t bucket(const double& t) {
+      if (t < 1.0) return 0;
+      const std::size_t b = static_cast<std::size_t>(std::log2(t) * 4.0) + 1;
+      return (b < bucket_count ? b : bucket_count - 1);
+    };
+
+    //  Add a run time.
+    void add(const double& t) {
+      last = t;
+      if (samples == 0 || t < min) min = t;
+      if (t > max) max = t;
+      window_sum += t - window[window_pos];
+      window[window_pos] = t;
+      window_pos = (window_pos + 1) % window_size;
+      histogram[bucket(t)]++;
+      samples++;
+    };
+
+    std::array<double, window_size> window = {};  //  Recent run times.
+    std::size_t window_pos = 0;                   //  Next position in the window.
+    double window_sum = 0.0;                      //  Sum of the window.
+
+  public:
+    std::uint64_t samples = 0;  //!<  Number of runs recorded.
+    double last = 0.0;          //!<  Time of the last run.
+    double min = 0.0;           //!<  Shortest run.
+    double max = 0.0;           //!<  Longest run.
+    //!  Number of runs in each histogram bucket.
+    std::array<std::uint64_t, bucket_count> histogram = {};
+
+    /*!
+     * \brief Get the average time of the recent runs.
+     * \return Average over the last window_size runs.
+     */
+    double average(void) const {
+      const std::size_t n = (samples < window_size ? samples : window_size);
+      return (n == 0 ? 0.0 : window_sum / n);
+    };
+
+    /*!
+     * \brief Get the upper time of a histogram bucket.
+     * \param b Bucket number.
+     * \return Runs in the bucket took less than this time.
+     */
+    static double bucket_limit(const std::size_t& b) {
+      return std::exp2(static_cast<double>(b) / 4.0);
+    };
+
+    /*!
+     * \brief Estimate a percentile of all recorded runs from the histogram.
+     * \param p Percentile, from 0 to 100.
+     * \return Time that the percentile of runs finished within.
+     */
+    double percentile(const double& p) const {
+      if (samples == 0) return 0.0;
+      const double target = samples * p / 100.0;
+      std::uint64_t count = 0;
+      for (std::size_t b = 0; b < bucket_count; b++) {
+        count += histogram[b];
+        if (count >= target && count > 0) return (bucket_limit(b) < max ? bucket_limit(b) : max);
+      }
+      return max;
+    };
+};
+
+/*!
+ * \class profiler
+ * \brief Records how long each system takes to run.
+ *
+ * Systems are timed each tick when the engine is built with SLV_ENABLE_PROFILER.
+ * Otherwise no timing is done and no timings are recorded.
+ */
+class profiler final {
+  friend class mgr::systems;
+
+  private:
+    //  Add a system to be timed.  Must be done before it runs.
+    static void add(const std::string& name) { _timings[name]; };
+
+    //  Record a run of a system.
+    static void record(const std::string& name, const double& t) {
+      auto it = _timings.find(name);
+      if (it != _timings.end()) it->second.add(t);
+    };
+
+    inline static std::map<const std::string, system_timing> _timings;  //  Timings by system name.
+
+  public:
+    profiler() = delete;                       //  Delete constructor.
+    ~profiler() = delete;                      //  Delete destructor.
+    profiler(const profiler&) = delete;        //  Delete copy constructor.
+    void operator=(profiler const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \brief Get the timings of all systems.
+     * \return Timings by system name.
+     */
+    static const std::map<const std::string, system_timing>& timings(void) { return _timings; };
+
+    /*!
+     * \brief Get the timing of a system.
+     * \param name Name of the system.
+     * \param t Set to the system's timing if found.
+     * \return True if the system has been timed, false if not.
+     */
+    static bool get(const std::string& name, system_timing& t) {
+      auto it = _timings.find(name);
+      if (it == _timings.end()) return false;
+      t = it->second;
+      return true;
+    };
+
+    /*!
+     * \brief Clear all recorded timings.
+     */
+    static void reset(void) {
+      for (auto& it: _timings) it.second = system_timing();
+    };
+
+    /*!
+     * \brief Write the timings to a CSV file.
+     * \param fname Filename to write to.
+     * \return True if written, false if the file could not be opened.
+     */
+    static bool dump(const std::string& fname) {
+      std::ofstream file(fname, std::ios::out | std::ios::trunc);
+      if (!file.is_open()) return false;
+      file << "System, Runs, Last, Min, Max, Average, P50, P90, P99\n";
+      for (auto& it: _timings) {
+        const system_timing& t = it.second;
+        file << it.first << ", " << t.samples << ", " << t.last << ", " << t.min << ", " << t.max << ", " <<
+          t.average() << ", " << t.percentile(50.0) << ", " << t.percentile(90.0) << ", " << t.percentile(99.0) << "\n";
+      }
+      return true;
+    };
+};
+
+}
+
+#endif
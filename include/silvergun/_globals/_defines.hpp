@@ -34,6 +34,13 @@
   #define SLV_DEBUG_MODE FALSE
 #endif
 
+//  Enable the system profiler
+#if defined(SLV_ENABLE_PROFILER)
+  #define SLV_PROFILER TRUE
+#else
+  #define SLV_PROFILER FALSE
+#endif
+
 //  Require OpenGL 3.0
 #if !defined(SLV_REQUIRE_OPENGL_LATEST)
   #define SLV_OPENGL_LATEST TRUE
@@ -52,6 +59,12 @@
   #define SLV_MAX_PLAYING_SAMPLES (12)
 #endif
 
+//  Set the number of worker threads used to run systems.
+//  Zero uses one less than the number of hardware threads.
+#if !defined(SLV_WORKER_THREADS)
+  #define SLV_WORKER_THREADS (0)
+#endif
+
 //  Toggle keyboard building
 #if !defined(SLV_DISABLE_KEYBOARD)
   #define SLV_USE_KEYBOARD TRUE
@@ -91,9 +104,11 @@ namespace slv {
  */
 struct slv_build_options {
   inline constexpr static bool debug_mode = static_cast<bool>(SLV_DEBUG_MODE);
+  inline constexpr static bool profiler_enabled = static_cast<bool>(SLV_PROFILER);
   inline constexpr static bool opengl_latest = static_cast<bool>(SLV_OPENGL_LATEST);
   inline constexpr static float ticks_per_sec = static_cast<float>(SLV_TICKS_PER_SECOND);
   inline constexpr static int max_playing_samples = static_cast<int>(SLV_MAX_PLAYING_SAMPLES);
+  inline constexpr static std::size_t worker_threads = static_cast<std::size_t>(SLV_WORKER_THREADS);
 
   //  Input options
   inline constexpr static bool keyboard_enabled = static_cast<bool>(SLV_USE_KEYBOARD);
@@ -0,0 +1,292 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_JOB_POOL_HPP)
+#define SLV_JOB_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <cstddef>
+
+#include "silvergun/_globals/_defines.hpp"
+
+namespace slv {
+
+class job_pool;
+
+/*!
+ * \class job_fence
+ * \brief Tracks a group of jobs so they can be waited on together.
+ */
+class job_fence final {
+  friend class job_pool;
+
+  private:
+    std::atomic<std::size_t> remaining = 0;  //  Number of jobs not finished.
+    std::exception_ptr error;                //  First exception thrown by a job.
+    std::mutex error_mtx;                    //  Lock for setting the exception.
+
+  public:
+    job_fence() = default;                     //  Default constructor.
+    ~job_fence() = default;                    //  Default destructor.
+    job_fence(const job_fence&) = delete;      //  Delete copy constructor.
+    void operator=(job_fence const&) = delete; //  Delete assignment operator.
+
+    /*!
+     * \brief Check if all jobs have finished.
+     * \return True if no jobs are left.
+     */
+    bool done(void) const { return remaining == 0; };
+};
+
+/*!
+ * \class job_pool
+ * \brief Work stealing pool of worker threads.
+ *
+ * Each worker has its own queue.  Workers run their newest jobs first
+ * and take the oldest jobs from other queues when their own is empty.
+ * Jobs submitted from other threads go in a shared queue.
+ * Threads waiting on a fence run jobs while they wait, so jobs can submit and wait on more jobs.
+ *
+ * Workers are started the first time they are needed.
+ * The number of workers is set by the SLV_WORKER_THREADS build option.
+ */
+class job_pool final {
+  private:
+    //  A queued job and the fence it belongs to.
+    struct job {
+      std::function<void(void)> func;
+      job_fence* fence;
+    };
+
+    //  Jobs waiting to run on one queue.
+    struct job_queue {
+      std::deque<job> jobs;
+      std::mutex mtx;
+    };
+
+    //  Worker threads and their queues.
+    struct pool_state {
+      ~pool_state() {
+        stop = true;
+        {
+          std::lock_guard<std::mutex> lock(sleep_mtx);
+        }
+        wake.notify_all();
+        for (auto& it: threads) it.join();
+      };
+
+      std::vector<std::thread> threads;                //  Worker threads.
+      std::vector<std::unique_ptr<job_queue>> queues;  //  One queue per worker, then the shared queue.
+      std::atomic<std::size_t> queued = 0;             //  Number of jobs in all queues.
+      std::atomic<bool> stop = false;                  //  Workers should exit.
+      std::mutex sleep_mtx;                            //  Lock for sleeping workers.
+      std::condition_variable wake;                    //  Signals workers that jobs were queued.
+      std::once_flag started;                          //  Workers have been started.
+    };
+
+    //  Queue number of the current thread, if it is a worker.
+    inline static thread_local std::size_t worker_index = std::numeric_limits<std::size_t>::max();
+
+    //  Get the pool state, starting the workers the first time.
+    static pool_state& get_state(void) {
+      static pool_state _state;
+      std::call_once(_state.started, [](){ start(_state); });
+      return _state;
+    };
+
+    //  Start the worker threads.
+    static void start(pool_state& st) {
+      std::size_t count = build_options.worker_threads;
+      if (count == 0) {
+        const std::size_t hw = std::thread::hardware_concurrency();
+        count = (hw > 1 ? hw - 1 : 0);
+      }
+      for (std::size_t i = 0; i <= count; i++) st.queues.push_back(std::make_unique<job_queue>());
+      for (std::size_t i = 0; i < count; i++) st.threads.emplace_back(work, std::ref(st), i);
+    };
+
+    //  Queue used by the current thread.
+    static std::size_t own_queue(const pool_state& st) {
+      return (worker_index < st.threads.size() ? worker_index : st.threads.size());
+    };
+
+    //  Add a job to the current thread's queue.
+    static void push(pool_state& st, job&& j) {
+      job_queue& q = *st.queues[own_queue(st)];
+      {
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.jobs.push_back(std::move(j));
+      }
+      st.queued++;
+      {
+        std::lock_guard<std::mutex> lock(st.sleep_mtx);
+      }
+      st.wake.notify_one();
+    };
+
+    //  Take a job, newest first from the thread's own queue, oldest first from the others.
+    static bool pop(pool_state& st, job& j) {
+      if (st.queued == 0) return false;
+      const std::size_t self = own_queue(st);
+      const std::size_t count = st.queues.size();
+      for (std::size_t i = 0; i < count; i++) {
+        job_queue& q = *st.queues[(self + i) % count];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.jobs.empty()) continue;
+        if (i == 0) {
+          j = std::move(q.jobs.back());
+          q.jobs.pop_back();
+        } else {
+          j = std::move(q.jobs.front());
+          q.jobs.pop_front();
+        }
+        st.queued--;
+        return true;
+      }
+      return false;
+    };
+
+    //  Run a job and record it as finished.
+    static void run_job(job& j) {
+      try {
+        j.func();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(j.fence->error_mtx);
+        if (!j.fence->error) j.fence->error = std::current_exception();
+      }
+      j.fence->remaining--;
+    };
+
+    //  Worker thread loop.
+    static void work(pool_state& st, const std::size_t index) {
+      worker_index = index;
+      job j;
+      while (!st.stop) {
+        if (pop(st, j)) {
+          run_job(j);
+          continue;
+        }
+        std::unique_lock<std::mutex> lock(st.sleep_mtx);
+        st.wake.wait(lock, [&st]{ return st.stop || st.queued > 0; });
+      }
+    };
+
+  public:
+    job_pool() = delete;                       //  Delete constructor.
+    ~job_pool() = delete;                      //  Delete destructor.
+    job_pool(const job_pool&) = delete;        //  Delete copy constructor.
+    void operator=(job_pool const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \brief Queue a job.
+     *
+     * If there are no worker threads the job is run now.
+     *
+     * \param fence Fence to track the job with.
+     * \param func Job to run.
+     */
+    static void submit(job_fence& fence, std::function<void(void)> func) {
+      pool_state& st = get_state();
+      fence.remaining++;
+      job j = { std::move(func), &fence };
+      if (st.threads.empty()) run_job(j);
+      else push(st, std::move(j));
+    };
+
+    /*!
+     * \brief Wait for all jobs tracked by a fence, running queued jobs while waiting.
+     * \param fence Fence to wait on.
+     * \exception Rethrows the first exception thrown by a job.
+     */
+    static void wait(job_fence& fence) {
+      pool_state& st = get_state();
+      job j;
+      while (fence.remaining > 0) {
+        if (pop(st, j)) run_job(j);
+        else std::this_thread::yield();
+      }
+      if (fence.error) {
+        std::exception_ptr error = fence.error;
+        fence.error = nullptr;
+        std::rethrow_exception(error);
+      }
+    };
+
+    /*!
+     * \brief Run a batch of jobs and wait for them to finish.
+     * \param jobs Jobs to run.
+     * \exception Rethrows the first exception thrown by a job, once all jobs have finished.
+     */
+    static void run(std::vector<std::function<void(void)>>& jobs) {
+      if (jobs.empty()) return;
+      if (jobs.size() == 1 || size() == 0) {
+        for (auto& it: jobs) it();
+        return;
+      }
+      job_fence fence;
+      for (std::size_t i = 1; i < jobs.size(); i++) submit(fence, jobs[i]);
+      try {
+        jobs[0]();
+      } catch (...) {
+        wait(fence);
+        throw;
+      }
+      wait(fence);
+    };
+
+    /*!
+     * \brief Split a range into chunks and run them in parallel.
+     *
+     * Returns once every chunk has finished.
+     *
+     * \param begin First index.
+     * \param end One past the last index.
+     * \param grain Most indices given to one chunk.
+     * \param func Called with the first and one past the last index of each chunk.
+     * \exception Rethrows the first exception thrown by a chunk.
+     */
+    template <typename F>
+    static void parallel_for(const std::size_t& begin, const std::size_t& end, std::size_t grain, const F& func) {
+      if (begin >= end) return;
+      if (grain == 0) grain = 1;
+      if (end - begin <= grain || size() == 0) {
+        func(begin, end);
+        return;
+      }
+      job_fence fence;
+      for (std::size_t b = begin + grain; b < end; b += grain) {
+        const std::size_t e = (end - b > grain ? b + grain : end);
+        submit(fence, [&func, b, e](){ func(b, e); });
+      }
+      try {
+        func(begin, begin + grain);
+      } catch (...) {
+        wait(fence);
+        throw;
+      }
+      wait(fence);
+    };
+
+    /*!
+     * \brief Get the number of worker threads.
+     * \return Number of workers, not counting the calling thread.
+     */
+    static std::size_t size(void) { return get_state().threads.size(); };
+};
+
+}
+
+#endif
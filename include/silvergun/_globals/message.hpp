@@ -13,6 +13,8 @@
 #include <sstream>
 #include <cstdint>
 
+#include "silvergun/_globals/symbols.hpp"
+
 namespace slv {
 
 /*!
@@ -42,8 +44,8 @@ class message final {
 
     int64_t timer;      //  Timer value that the message will be processed at
     std::string sys;    //  System that will process the message
-    std::string to;     //  Message to entity field
-    std::string from;   //  Message from entity field
+    symbol to;          //  Message to entity field
+    symbol from;        //  Message from entity field
     std::string cmd;    //  Message command
     msg_args args;      //  Message arguments
 
@@ -60,7 +62,7 @@ class message final {
       const std::string& s,
       const std::string& c,
       const std::string& a
-    ) : timer(-1), sys(s), to(""), from(""), cmd(c) {
+    ) : timer(-1), sys(s), to(0), from(0), cmd(c) {
       split_args(a);
     };
 
@@ -76,7 +78,7 @@ class message final {
       const std::string& s,
       const std::string& c,
       const std::string& a
-    ) : timer(e), sys(s), to(""), from(""), cmd(c) {
+    ) : timer(e), sys(s), to(0), from(0), cmd(c) {
       split_args(a);
     };
 
@@ -94,7 +96,7 @@ class message final {
       const std::string& f,
       const std::string& c,
       const std::string& a
-    ) : timer(-1), sys(s), to(t), from(f), cmd(c) {
+    ) : timer(-1), sys(s), to(symbols::intern(t)), from(symbols::intern(f)), cmd(c) {
       split_args(a);
     };
 
@@ -114,7 +116,25 @@ class message final {
       const std::string& f,
       const std::string& c,
       const std::string& a
-    ) : timer(e), sys(s), to(t), from(f), cmd(c) {
+    ) : timer(e), sys(s), to(symbols::intern(t)), from(symbols::intern(f)), cmd(c) {
+      split_args(a);
+    };
+
+    /*!
+     * \brief Create a non-timed message with a to & from by symbol.
+     * \param s System.
+     * \param t To.
+     * \param f From.
+     * \param c Command.
+     * \param a Arguments delimited by ;
+     */
+    message(
+      const std::string& s,
+      const symbol& t,
+      const symbol& f,
+      const std::string& c,
+      const std::string& a
+    ) : timer(-1), sys(s), to(t), from(f), cmd(c) {
       split_args(a);
     };
 
@@ -146,6 +166,14 @@ class message final {
      * \return The value of to.
      */
     const std::string get_to(void) const {
+      return symbols::str(to);
+    };
+
+    /*!
+     * \brief Get to value as a symbol.
+     * \return The symbol of to.
+     */
+    symbol get_to_symbol(void) const {
       return to;
     };
 
@@ -154,6 +182,14 @@ class message final {
      * \return The value of from.
      */
     const std::string get_from(void) const {
+      return symbols::str(from);
+    };
+
+    /*!
+     * \brief Get from value as a symbol.
+     * \return The symbol of from.
+     */
+    symbol get_from_symbol(void) const {
       return from;
     };
 
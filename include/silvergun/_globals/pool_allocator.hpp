@@ -0,0 +1,226 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_POOL_ALLOCATOR_HPP)
+#define SLV_POOL_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+namespace slv {
+
+template <typename T>
+class memory_pool;
+
+/*!
+ * \class memory_pools
+ * \brief Tracks every memory pool in use so they can be released together.
+ */
+class memory_pools final {
+  template <typename T>
+  friend class memory_pool;
+
+  private:
+    //  Release functions for each memory pool in use.
+    inline static std::vector<void(*)(void)> release_funcs;
+
+  public:
+    memory_pools() = delete;                       //  Delete constructor.
+    ~memory_pools() = delete;                      //  Delete destructor.
+    memory_pools(const memory_pools&) = delete;    //  Delete copy constructor.
+    void operator=(memory_pools const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \brief Free the memory of every pool that has no blocks in use.
+     */
+    static void release(void) {
+      for (auto& it: release_funcs) it();
+    };
+};
+
+/*!
+ * \class memory_pool
+ * \brief Hands out single blocks for objects of one type from chunks of memory.
+ *
+ * Freed blocks are kept on a free list and reused.
+ * Chunks are only returned to the system by release, never at static destruction,
+ * so objects destroyed at program exit can still return their blocks.
+ * Safe to use from multiple threads.
+ *
+ * \tparam T Type of object stored.
+ */
+template <typename T>
+class memory_pool final {
+  private:
+    //  A block is either free and linked in the free list or holds an object.
+    union block {
+      block* next;
+      alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    //  Add a chunk of blocks to the free list.
+    static void grow(const std::size_t& count) {
+      if (chunks.empty()) {
+        //  Register with the pool tracker the first time memory is used.
+        static const bool registered = [](){ memory_pools::release_funcs.push_back(&release); return true; }();
+        (void)registered;
+      }
+      block* chunk = new block[count];
+      chunks.push_back(chunk);
+      for (std::size_t i = 0; i < count; i++) {
+        chunk[i].next = free_list;
+        free_list = &chunk[i];
+      }
+      capacity += count;
+    };
+
+    inline static std::vector<block*> chunks;                    //  Allocated chunks.
+    inline static block* free_list = nullptr;                    //  First free block.
+    inline static std::size_t capacity = 0;                      //  Number of blocks in all chunks.
+    inline static std::size_t used = 0;                          //  Number of blocks in use.
+    inline static std::mutex mtx;                                //  Lock for use from multiple threads.
+
+  public:
+    memory_pool() = delete;                      //  Delete constructor.
+    ~memory_pool() = delete;                     //  Delete destructor.
+    memory_pool(const memory_pool&) = delete;    //  Delete copy constructor.
+    void operator=(memory_pool const&) = delete; //  Delete assignment operator.
+
+    //!  Number of blocks allocated in each new chunk.
+    inline static const std::size_t chunk_size = 256;
+
+    /*!
+     * \brief Make sure a number of blocks can be allocated without growing again.
+     * \param count Number of blocks to have free.
+     */
+    static void reserve(const std::size_t& count) {
+      std::lock_guard<std::mutex> lock(mtx);
+      const std::size_t available = capacity - used;
+      if (count > available) grow(count - available);
+    };
+
+    /*!
+     * \brief Get a block for a single object.
+     * \return Pointer to uninitialized memory for the object.
+     */
+    static T* allocate(void) {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (free_list == nullptr) grow(chunk_size);
+      block* b = free_list;
+      free_list = b->next;
+      used++;
+      return reinterpret_cast<T*>(b->data);
+    };
+
+    /*!
+     * \brief Return a block to the pool.
+     * \param p Pointer to the block, the object must already be destroyed.
+     */
+    static void deallocate(T* p) {
+      std::lock_guard<std::mutex> lock(mtx);
+      block* b = reinterpret_cast<block*>(p);
+      b->next = free_list;
+      free_list = b;
+      used--;
+    };
+
+    /*!
+     * \brief Free all chunks if no blocks are in use.
+     */
+    static void release(void) {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (used > 0) return;
+      free_list = nullptr;
+      for (auto& it: chunks) delete[] it;
+      chunks.clear();
+      capacity = 0;
+    };
+};
+
+/*!
+ * \class pool_allocator
+ * \brief Standard allocator that takes single objects from a memory_pool.
+ *
+ * Used with std::allocate_shared so an object and its control block share one pooled block.
+ * Requests for more than one object fall back to the standard allocator.
+ *
+ * \tparam T Type of object allocated.
+ * \tparam Tag Type the allocator was created for.  Kept when rebound to other types.
+ */
+template <typename T, typename Tag = T>
+class pool_allocator {
+  template <typename, typename>
+  friend class pool_allocator;
+
+  private:
+    //  Blocks to reserve on the next allocation made for the tag.
+    inline static std::atomic<std::size_t> reserved = 0;
+
+  public:
+    using value_type = T;  //!<  Type of object allocated.
+
+    pool_allocator() noexcept = default;  //  Default constructor.
+
+    //!  Construct from an allocator of another type.
+    template <typename U>
+    pool_allocator(const pool_allocator<U, Tag>&) noexcept {};
+
+    /*!
+     * \brief Reserve blocks for objects allocated for the tag.
+     *
+     * The allocated type may differ from the tag, for example when
+     * std::allocate_shared rebinds to its control block.
+     * The blocks are reserved on the next allocation.
+     *
+     * \param n Number of objects to reserve blocks for.
+     */
+    static void reserve(const std::size_t& n) {
+      std::atomic<std::size_t>& r = pool_allocator<Tag, Tag>::reserved;
+      if (n > r) r = n;
+    };
+
+    /*!
+     * \brief Allocate memory for objects.
+     * \param n Number of objects.
+     * \return Pointer to uninitialized memory.
+     */
+    T* allocate(const std::size_t n) {
+      if (n == 1) {
+        if (pool_allocator<Tag, Tag>::reserved > 0) {
+          const std::size_t r = pool_allocator<Tag, Tag>::reserved.exchange(0);
+          if (r > 0) memory_pool<T>::reserve(r);
+        }
+        return memory_pool<T>::allocate();
+      }
+      return std::allocator<T>().allocate(n);
+    };
+
+    /*!
+     * \brief Free memory for objects.
+     * \param p Pointer to the memory.
+     * \param n Number of objects.
+     */
+    void deallocate(T* p, const std::size_t n) noexcept {
+      if (n == 1) memory_pool<T>::deallocate(p);
+      else std::allocator<T>().deallocate(p, n);
+    };
+
+    //!  All pool allocators share the same pools.
+    template <typename U, typename G>
+    bool operator==(const pool_allocator<U, G>&) const noexcept { return true; };
+
+    //!  All pool allocators share the same pools.
+    template <typename U, typename G>
+    bool operator!=(const pool_allocator<U, G>&) const noexcept { return false; };
+};
+
+}
+
+#endif
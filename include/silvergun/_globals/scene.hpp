@@ -9,6 +9,7 @@
 #define SLV_SCENE_HPP
 
 #include <string>
+#include <vector>
 
 #include "silvergun/_globals/handlers.hpp"
 
@@ -24,8 +25,10 @@ class scene {
      * \brief Construct a new scene.
      * \param n Scene name.
      * \param s Scene handler scope.
+     * \param sys Names of the systems to run in the scene.  Empty runs all systems.
      */
-    scene(const std::string& n, const std::size_t& s) : name(n), scope(s) {
+    scene(const std::string& n, const std::size_t& s, const std::vector<std::string>& sys = {}) :
+    name(n), scope(s), systems(sys) {
       assert(s == SCOPE_A || s == SCOPE_B || s == SCOPE_C &&
         "Scope must be one of the following: SCOPE_A, SCOPE_B, SCOPE_C");
     };
@@ -52,6 +55,7 @@ class scene {
 
     const std::string name;   //!<  Scene name.
     const std::size_t scope;  //!<  Scene handler scope.
+    const std::vector<std::string> systems;  //!<  Systems run in the scene, all if empty.
 };
 
 }
@@ -0,0 +1,153 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_SNAPSHOT_HPP)
+#define SLV_SNAPSHOT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "silvergun/_debug/exceptions.hpp"
+
+namespace slv {
+
+/*!
+ * \class snapshot
+ * \brief Binary buffer for saving and restoring engine state.
+ *
+ * Values are appended when writing and read back in the same order.
+ */
+class snapshot final {
+  private:
+    std::vector<std::uint8_t> data;  //  Snapshot bytes.
+    std::size_t read_pos;            //  Position of the next read.
+
+    //  Make sure enough data is left to read.
+    void check(const std::size_t& n) const {
+      if (read_pos + n > data.size())
+        throw engine_exception("Snapshot data ended early", "Snapshot", 2);
+    };
+
+  public:
+    /*!
+     * \brief Create an empty snapshot.
+     */
+    snapshot() : read_pos(0) {};
+
+    /*!
+     * \brief Create a snapshot from saved data.
+     * \param d Snapshot bytes.
+     */
+    snapshot(const std::vector<std::uint8_t>& d) : data(d), read_pos(0) {};
+
+    ~snapshot() = default;  //  Default destructor.
+
+    /*!
+     * \brief Append a value.
+     * \tparam T Value type, must be trivially copyable.
+     * \param value Value to write.
+     */
+    template <typename T>
+    void write(const T& value) {
+      static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable!");
+      const std::size_t pos = data.size();
+      data.resize(pos + sizeof(T));
+      std::memcpy(data.data() + pos, &value, sizeof(T));
+    };
+
+    /*!
+     * \brief Replace a value written earlier.
+     * \tparam T Value type, must be trivially copyable.
+     * \param pos Position of the value, from size before it was written.
+     * \param value Value to write.
+     */
+    template <typename T>
+    void write_at(const std::size_t& pos, const T& value) {
+      static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable!");
+      std::memcpy(data.data() + pos, &value, sizeof(T));
+    };
+
+    /*!
+     * \brief Append a string.
+     * \param str String to write.
+     */
+    void write_string(const std::string& str) {
+      write<std::uint32_t>(static_cast<std::uint32_t>(str.size()));
+      data.insert(data.end(), str.begin(), str.end());
+    };
+
+    /*!
+     * \brief Read the next value.
+     * \tparam T Value type, must be trivially copyable.
+     * \return The value read.
+     * \exception engine_exception Not enough data left.
+     */
+    template <typename T>
+    T read(void) {
+      static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable!");
+      check(sizeof(T));
+      T value;
+      std::memcpy(&value, data.data() + read_pos, sizeof(T));
+      read_pos += sizeof(T);
+      return value;
+    };
+
+    /*!
+     * \brief Read the next string.
+     * \return The string read.
+     * \exception engine_exception Not enough data left.
+     */
+    std::string read_string(void) {
+      const std::size_t n = read<std::uint32_t>();
+      check(n);
+      std::string str(reinterpret_cast<const char*>(data.data() + read_pos), n);
+      read_pos += n;
+      return str;
+    };
+
+    /*!
+     * \brief Skip over data without reading it.
+     * \param n Number of bytes to skip.
+     * \exception engine_exception Not enough data left.
+     */
+    void skip(const std::size_t& n) {
+      check(n);
+      read_pos += n;
+    };
+
+    /*!
+     * \brief Start reading from the beginning again.
+     */
+    void rewind(void) { read_pos = 0; };
+
+    /*!
+     * \brief Remove all data.
+     */
+    void clear(void) {
+      data.clear();
+      read_pos = 0;
+    };
+
+    /*!
+     * \brief Get the snapshot bytes, for writing to a file.
+     * \return The snapshot data.
+     */
+    const std::vector<std::uint8_t>& get_data(void) const { return data; };
+
+    /*!
+     * \brief Get the size of the snapshot.
+     * \return Number of bytes.
+     */
+    std::size_t size(void) const { return data.size(); };
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_SYMBOLS_HPP)
+#define SLV_SYMBOLS_HPP
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <cstdint>
+
+namespace slv {
+
+/*!
+ * \typedef std::uint32_t symbol
+ * Interned string.
+ */
+using symbol = std::uint32_t;
+
+/*!
+ * \class symbols
+ * \brief Table of interned strings.
+ *
+ * Each string is given a stable integer symbol the first time it is interned,
+ * so names can be stored and compared as integers.
+ * The empty string is always symbol 0.
+ * The table is cleared when a scene is loaded, so it does not grow for the life of the game.
+ */
+class symbols final {
+  private:
+    //  Lookup tables, with the empty string as symbol 0.
+    struct table {
+      table() {
+        names.push_back("");
+        index.insert(std::make_pair("", 0));
+      };
+
+      std::deque<std::string> names;                   //  Strings by symbol.
+      std::unordered_map<std::string, symbol> index;  //  Symbols by string.
+      std::shared_mutex mtx;                           //  Lock for interning from multiple threads.
+    };
+
+    //  Get the lookup tables.
+    static table& get_table(void) {
+      static table _table;
+      return _table;
+    };
+
+  public:
+    symbols() = delete;                       //  Delete constructor.
+    ~symbols() = delete;                      //  Delete destructor.
+    symbols(const symbols&) = delete;         //  Delete copy constructor.
+    void operator=(symbols const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \brief Get the symbol for a string, adding it to the table if needed.
+     * \param str String to intern.
+     * \return The string's symbol.
+     */
+    static symbol intern(const std::string& str) {
+      table& t = get_table();
+      {
+        std::shared_lock<std::shared_mutex> lock(t.mtx);
+        const auto it = t.index.find(str);
+        if (it != t.index.end()) return it->second;
+      }
+
+      std::unique_lock<std::shared_mutex> lock(t.mtx);
+      const auto it = t.index.find(str);  //  Check again, it may have been added while unlocked.
+      if (it != t.index.end()) return it->second;
+
+      const symbol sym = static_cast<symbol>(t.names.size());
+      t.names.push_back(str);
+      t.index.insert(std::make_pair(str, sym));
+      return sym;
+    };
+
+    /*!
+     * \brief Get the symbol for a string without adding it.
+     * \param str String to find.
+     * \param sym Set to the string's symbol if found.
+     * \return True if the string has been interned, false if not.
+     */
+    static bool find(const std::string& str, symbol& sym) {
+      table& t = get_table();
+      std::shared_lock<std::shared_mutex> lock(t.mtx);
+      const auto it = t.index.find(str);
+      if (it == t.index.end()) return false;
+      sym = it->second;
+      return true;
+    };
+
+    /*!
+     * \brief Get the string for a symbol.
+     *
+     * The reference is valid until the table is cleared.
+     *
+     * \param sym Symbol to look up.
+     * \return The interned string, empty if the symbol is not in the table.
+     */
+    static const std::string& str(const symbol& sym) {
+      table& t = get_table();
+      std::shared_lock<std::shared_mutex> lock(t.mtx);
+      if (sym >= t.names.size()) return t.names[0];
+      return t.names[sym];
+    };
+
+    /*!
+     * \brief Remove every symbol except the empty string.
+     *
+     * Symbols from before are no longer valid, and may be given to other strings.
+     * Called by the engine when a scene is loaded, after the world and messages are cleared.
+     */
+    static void clear(void) {
+      table& t = get_table();
+      std::unique_lock<std::shared_mutex> lock(t.mtx);
+      t.names.resize(1);
+      t.index.clear();
+      t.index.insert(std::make_pair("", 0));
+    };
+};
+
+}
+
+#endif
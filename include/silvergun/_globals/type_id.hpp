@@ -0,0 +1,54 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_TYPE_ID_HPP)
+#define SLV_TYPE_ID_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <type_traits>
+
+namespace slv {
+
+/*!
+ * \class type_id
+ * \brief Assigns each type a unique integer ID without using RTTI.
+ *
+ * IDs are numbered from zero in the order types are first used,
+ * separately for each family of types.
+ *
+ * \tparam F Family the IDs belong to.
+ */
+template <typename F>
+class type_id final {
+  private:
+    inline static std::atomic<std::size_t> counter = 0;  //  Next ID to assign.
+
+  public:
+    type_id() = delete;                       //  Delete constructor.
+    ~type_id() = delete;                      //  Delete destructor.
+    type_id(const type_id&) = delete;         //  Delete copy constructor.
+    void operator=(type_id const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \brief Get the ID for a type.
+     * \tparam T Type to get the ID for.  Const and volatile qualifiers are ignored.
+     * \return The type's ID.
+     */
+    template <typename T>
+    static std::size_t get(void) {
+      if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>) return get<std::remove_cv_t<T>>();
+      else {
+        static const std::size_t id = counter++;
+        return id;
+      }
+    };
+};
+
+}
+
+#endif
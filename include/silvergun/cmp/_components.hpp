@@ -16,6 +16,7 @@
 #include "silvergun/cmp/location.hpp"
 #include "silvergun/cmp/motion.hpp"
 #include "silvergun/cmp/overlay.hpp"
+#include "silvergun/cmp/parent.hpp"
 #include "silvergun/cmp/sprite.hpp"
 
 #endif
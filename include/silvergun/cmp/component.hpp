@@ -10,8 +10,30 @@
 
 #include <memory>
 
+#include "silvergun/_globals/type_id.hpp"
+
+namespace slv::mgr {
+  class world;
+}
+
 namespace slv::cmp {
 
+class component;
+
+/*!
+ * \typedef std::size_t component_id
+ * Integer ID of a component type.
+ */
+using component_id = std::size_t;
+
+/*!
+ * \brief Get the ID of a component type.
+ * \tparam T Component type.
+ * \return The component type's ID.
+ */
+template <typename T>
+inline component_id get_type_id(void) { return type_id<component>::get<T>(); };
+
 /*!
  * \class component
  * \brief Interface class for creating a component.
@@ -19,13 +41,33 @@ namespace slv::cmp {
  * Extend this to creata a component that can be loaded into the Entity Manager.
  */
 class component {
+  friend class mgr::world;
+
+  private:
+    component_id type;  //  Type ID of the component, set by the world.
+
   protected:
-    component() = default;                      //  Default constructor.
+    component() noexcept : type(get_type_id<component>()) {};  //  Default constructor.
 
   public:
     virtual ~component() = default;             //  Default virtual destructor.
     component(const component&) = delete;       //  Delete copy constructor.
     void operator=(component const&) = delete;  //  Delete assignment operator.
+
+    /*!
+     * \typedef component base_type
+     * Base class the component can be searched by.
+     *
+     * Interface classes such as cmp::gfx::gfx redefine this as themselves,
+     * so components derived from them can be found by the interface type.
+     */
+    using base_type = component;
+
+    /*!
+     * \brief Get the type ID of the component.
+     * \return Type ID, compare with get_type_id.
+     */
+    component_id get_type(void) const { return type; };
 };
 
 /*!
@@ -64,6 +64,9 @@ class gfx : public component {
     gfx() = delete;            //  Delete default constructor.
     virtual ~gfx() = default;  //  Default virtual destructor.
 
+    //!  Allow components to be searched for as gfx.
+    using base_type = gfx;
+
     /*!
      * \brief Overload < operator to sort by layer value.
      * \param a Object to compare to.
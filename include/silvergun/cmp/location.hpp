@@ -15,6 +15,8 @@ namespace slv::cmp {
 /*!
  * \class location
  * \brief Store the X/Y location of an entity in the arena.
+ *
+ * The location at the start of each tick is kept so drawing can be blended between ticks.
  */
 class location final : public component {
   public:
@@ -26,13 +28,15 @@ class location final : public component {
     location(
       const float& x,
       const float& y
-    ) : pos_x(x), pos_y(y) {};
+    ) noexcept : pos_x(x), pos_y(y), prev_x(x), prev_y(y) {};
 
     location() = delete;    //  Delete default constructor.
     ~location() = default;  //  Default destructor.
 
     float pos_x;  //!<  Entity X location.
     float pos_y;  //!<  Entity Y location.
+    float prev_x;  //!<  Entity X location at the start of the tick.  Set to pos_x to move without blending.
+    float prev_y;  //!<  Entity Y location at the start of the tick.  Set to pos_y to move without blending.
 };
 
 }
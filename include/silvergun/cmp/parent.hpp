@@ -0,0 +1,47 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_CMP_PARENT_HPP)
+#define SLV_CMP_PARENT_HPP
+
+#include "silvergun/cmp/component.hpp"
+
+#include "silvergun/mgr/world.hpp"
+
+namespace slv::cmp {
+
+/*!
+ * \class parent
+ * \brief Attach an entity to a parent entity.
+ *
+ * The Transform system sets the entity's location to the parent's location plus the offset.
+ */
+class parent final : public component {
+  public:
+    /*!
+     * \brief Create a new Parent component.
+     * \param p Entity ID of the parent.
+     * \param x Horizontal offset from the parent.
+     * \param y Vertical offset from the parent.
+     */
+    parent(
+      const entity_id& p,
+      const float& x,
+      const float& y
+    ) noexcept : parent_id(p), offset_x(x), offset_y(y) {};
+
+    parent() = delete;    //  Delete default constructor.
+    ~parent() = default;  //  Default destructor.
+
+    entity_id parent_id;  //!<  Parent entity ID.
+    float offset_x;       //!<  X offset from the parent's location.
+    float offset_y;       //!<  Y offset from the parent's location.
+};
+
+}
+
+#endif
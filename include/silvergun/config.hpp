@@ -46,6 +46,7 @@ class config {
       inline static bool touch_installed = false;
       inline static bool audio_installed = false;
       inline static bool show_hitboxes = false;
+      inline static bool headless = false;
     };
 
     struct _volume {
@@ -95,6 +96,17 @@ class config {
       inline static bool draw_fps = true;                                         //!<  Flag to check if fps should be drawn.
       inline static bool input_enabled = true;                                    //!<  Flag to check if game input is enabled.
       inline static const bool& show_hitboxes = _flags::show_hitboxes;            //!<  Flag to enable/disable hitbox rendering.
+      inline static const bool& headless = _flags::headless;                      //!<  Flag to check if running without display, audio or input.
+    };
+
+    /*!
+     * \struct sim
+     * \brief Simulation settings.
+     */
+    struct sim {
+      inline static std::size_t max_catch_up = 5;  //!<  Most ticks run before each render when the game falls behind.
+      inline static bool interpolate = true;       //!<  Draw locations blended between the last two ticks.
+      inline static double max_fps = 0.0;          //!<  Most frames drawn per second.  Zero for the display refresh rate.
     };
 
     /*!
@@ -13,6 +13,8 @@
 #include <vector>
 #include <map>
 #include <functional>
+#include <chrono>
+#include <thread>
 
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
@@ -36,8 +38,10 @@
 #include "silvergun/_globals/_defines.hpp"
 #include "silvergun/_globals/commands.hpp"
 #include "silvergun/_globals/engine_time.hpp"
+#include "silvergun/_globals/job_pool.hpp"
 #include "silvergun/_globals/scene.hpp"
 #include "silvergun/_globals/slv_asset.hpp"
+#include "silvergun/_globals/symbols.hpp"
 #include "silvergun/mgr/_managers.hpp"
 
 namespace slv {
@@ -66,11 +70,181 @@ class engine final : public config, public input, public display {
     engine() = default;
     ~engine() = default;
 
+    //  Register snapshot functions for the built-in components.
+    static void register_snapshots(void) {
+      mgr::world::reg_snapshot<cmp::location>("location",
+        [](const cmp::location& c, snapshot& s) {
+          s.write(c.pos_x);
+          s.write(c.pos_y);
+        },
+        [](const entity_id& e_id, snapshot& s) {
+          const float x = s.read<float>();
+          const float y = s.read<float>();
+          mgr::world::add_component<cmp::location>(e_id, x, y);
+        });
+      mgr::world::reg_snapshot<cmp::motion>("motion",
+        [](const cmp::motion& c, snapshot& s) {
+          s.write(c.direction);
+          s.write(c.x_vel);
+          s.write(c.y_vel);
+        },
+        [](const entity_id& e_id, snapshot& s) {
+          const float d = s.read<float>();
+          const float xv = s.read<float>();
+          const float yv = s.read<float>();
+          mgr::world::add_component<cmp::motion>(e_id, d, xv, yv);
+        });
+      mgr::world::reg_snapshot<cmp::hitbox>("hitbox",
+        [](const cmp::hitbox& c, snapshot& s) {
+          s.write(c.width);
+          s.write(c.height);
+          s.write<std::uint64_t>(c.team);
+          s.write<std::uint8_t>(c.solid ? 1 : 0);
+        },
+        [](const entity_id& e_id, snapshot& s) {
+          const float w = s.read<float>();
+          const float h = s.read<float>();
+          const std::size_t t = s.read<std::uint64_t>();
+          const bool solid = (s.read<std::uint8_t>() != 0);
+          mgr::world::add_component<cmp::hitbox>(e_id, w, h, t, solid);
+        });
+      mgr::world::reg_snapshot<cmp::bounding_box>("bounding_box",
+        [](const cmp::bounding_box& c, snapshot& s) {
+          s.write(c.min_x);
+          s.write(c.min_y);
+          s.write(c.max_x);
+          s.write(c.max_y);
+        },
+        [](const entity_id& e_id, snapshot& s) {
+          const float lx = s.read<float>();
+          const float ly = s.read<float>();
+          const float rx = s.read<float>();
+          const float ry = s.read<float>();
+          mgr::world::add_component<cmp::bounding_box>(e_id, lx, ly, rx, ry);
+        });
+      mgr::world::reg_snapshot<cmp::parent>("parent",
+        [](const cmp::parent& c, snapshot& s) {
+          s.write(c.parent_id);
+          s.write(c.offset_x);
+          s.write(c.offset_y);
+        },
+        [](const entity_id& e_id, snapshot& s) {
+          const entity_id p = s.read<entity_id>();
+          const float x = s.read<float>();
+          const float y = s.read<float>();
+          mgr::world::add_component<cmp::parent>(e_id, p, x, y);
+        });
+    };
+
+    //  Keep each location at the start of the tick, for blending when drawn.
+    static void store_locations(void) {
+      const auto& p = mgr::world::pool<cmp::location>();
+      job_pool::parallel_for(0, p.size(), 4096, [&p](const std::size_t& b, const std::size_t& e) {
+        for (std::size_t pos = b; pos < e; pos++) {
+          cmp::location* loc = static_cast<cmp::location*>(p.ptr_at(pos));
+          loc->prev_x = loc->pos_x;
+          loc->prev_y = loc->pos_y;
+        }
+      });
+    };
+
+    //  Run one tick of the game.
+    static void run_tick(void) {
+      //  Replay recorded input due before this tick, then count the tick.
+      if (input::is_replaying()) input::replay_events(current_scene->scope);
+      input::sim_ticks++;
+      //  Engine time counts the ticks run, so dropped ticks do not move it and replays match.
+      engine_time::set(input::sim_ticks);
+      store_locations();
+      //  Record changes to entities and components until systems and handlers finish.
+      //  The recorded changes are applied when the lock is released, even if a system throws.
+      struct tick_lock {
+        tick_lock() { mgr::world::lock(); };
+        ~tick_lock() { mgr::world::unlock(); };
+      } lock;
+      //  Run all systems.
+      mgr::systems::run();
+      //  Process messages.
+      mgr::messages::dispatch();
+      //  Get any spawner messages and pass to handler.
+      mgr::spawner::process_messages(mgr::messages::get("spawner"));
+    };
+
+    //  Load the systems and register snapshot types.
+    static void load_game(void) {
+      //  Load systems and prevent further systems from being loaded.
+      std::cout << "Loading systems... ";
+      load_systems();
+      mgr::systems::finalized = true;
+      if (mgr::systems::empty()) throw engine_error("No systems have been loaded!");
+      std::cout << "OK!\n";
+
+      register_snapshots();
+    };
+
+    //  Add the engine (system) commands and start logging.
+    static void add_commands(void) {
+      cmds.add("load-script", 1, [](const msg_args& args) {
+        if (input::is_replaying()) return;  //  Loaded from the recording instead.
+        input::record_script(args[0]);
+        mgr::messages::load_script(args[0]);
+      });
+      cmds.add("load-scene", 1, [](const msg_args& args) {
+        engine::load_scene(args[0]);
+      });
+      cmds.add("enable-system", 1, [](const msg_args& args) {
+        mgr::systems::enable(args[0]);
+      });
+      cmds.add("disable-system", 1, [](const msg_args& args) {
+        mgr::systems::disable(args[0]);
+      });
+      cmds.add("enable-input", 0, [](const msg_args& args) {
+        config::flags::input_enabled = true;
+      });
+      cmds.add("disable-input", 0, [](const msg_args& args) {
+        config::flags::input_enabled = false;
+      });
+
+      if constexpr (build_options.debug_mode) {
+        std::cout << "DEBUG MODE --- LOGGING ENABLED\n";
+        mgr::messages::message_log_start();
+        logger::start();
+      }
+    };
+
+    //  Main engine loop when headless.  Ticks are run from a virtual clock.
+    static void headless_loop(void) {
+      if (config::flags::engine_paused) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        next_tick_time = std::chrono::steady_clock::now();
+      } else {
+        //  Wait until the tick is due at the set speed.
+        if (headless_speed > 0.0) {
+          std::this_thread::sleep_until(next_tick_time);
+          next_tick_time += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / (build_options.ticks_per_sec * headless_speed)));
+        }
+        run_tick();
+      }
+
+      //  Run any custom scene code
+      current_scene->loop();
+      //  Process system messages
+      cmds.process_messages(mgr::messages::get("system"));
+      //  No audio, drop the audio messages.
+      mgr::messages::get("audio");
+      //  Delete unprocessed messages.
+      mgr::messages::prune();
+    };
+
     /*
      * Main engine loop (single pass)
      */
     static void main_loop(void) {
-      input::check_events(current_scene->scope);  //  Check for input.
+      if (config::flags::headless) {
+        headless_loop();
+        return;
+      }
 
       //  Pause / resume timer check.  Also process the on_pause events.
       if (config::flags::engine_paused && al_get_timer_started(main_timer)) {
@@ -82,20 +256,23 @@ class engine final : public config, public input, public display {
         al_resume_timer(main_timer);
       }
 
+      //  Sleep until an event arrives or the next frame is due.
       ALLEGRO_EVENT event;
-      if (al_get_next_event(main_event_queue, &event)) {
+      bool have_event = wait_for_event(event);
+
+      //  Process all waiting events, running every tick that is due.
+      //  If the game falls too far behind, the extra ticks are dropped.
+      std::size_t ticks = 0;
+      while (config::flags::is_running && have_event) {
         switch (event.type) {
         //  Call our game logic update on timer events.
         //  Timer is only running when the game is running.
         case ALLEGRO_EVENT_TIMER:
-          //  Set the engine_time object to the current time.
-          engine_time::set(al_get_timer_count(main_timer));
-          //  Run all systems.
-          mgr::systems::run();
-          //  Process messages.
-          mgr::messages::dispatch();
-          //  Get any spawner messages and pass to handler.
-          mgr::spawner::process_messages(mgr::messages::get("spawner"));
+          last_tick_time = event.timer.timestamp;
+          if (ticks >= config::sim::max_catch_up) break;
+          ticks++;
+          run_tick();
+          redraw = true;
           break;
         //  Check if display looses focus.
         case ALLEGRO_EVENT_DISPLAY_SWITCH_OUT:
@@ -104,6 +281,7 @@ class engine final : public config, public input, public display {
         //  Check if display returns to focus.
         case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
           back_in_focus();
+          redraw = true;
           break;
         //  Force quit if the game window is closed.
         case ALLEGRO_EVENT_DISPLAY_CLOSE:
@@ -112,15 +290,36 @@ class engine final : public config, public input, public display {
         //  Window has been resized.
         case ALLEGRO_EVENT_DISPLAY_RESIZE:
           al_acknowledge_resize(_display);
+          redraw = true;
+          break;
+        //  Window needs to be drawn again.
+        case ALLEGRO_EVENT_DISPLAY_EXPOSE:
+          redraw = true;
+          break;
+        //  Everything else is input.
+        default:
+          input::handle_event(current_scene->scope, event);
+          redraw = true;
           break;
         }
+        have_event = al_get_next_event(main_event_queue, &event);
       }
 
       //  Run any custom scene code
       current_scene->loop();
 
-      //  Render the screen.
-      mgr::gfx::renderer::render();
+      if (frame_due()) {
+        //  Find how far into the next tick the render is.
+        if (al_get_timer_started(main_timer)) {
+          const double alpha = (al_get_time() - last_tick_time) * build_options.ticks_per_sec;
+          mgr::gfx::renderer::_alpha = static_cast<float>(alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha));
+        } else mgr::gfx::renderer::_alpha = 1.0f;
+
+        //  Render the screen.
+        mgr::gfx::renderer::render();
+        last_frame_time = al_get_time();
+        redraw = false;
+      }
       //  Process system messages
       cmds.process_messages(mgr::messages::get("system"));
       //  Send audio messages to the audio queue.
@@ -129,6 +328,46 @@ class engine final : public config, public input, public display {
       mgr::messages::prune();
     };
 
+    //  Check if frames are drawn between ticks to show the interpolation.
+    static bool animating(void) {
+      return config::sim::interpolate && al_get_timer_started(main_timer);
+    };
+
+    //  Most frames drawn per second.
+    static double frame_rate(void) {
+      if (config::sim::max_fps > 0.0) return config::sim::max_fps;
+      if (refresh_rate > 0) return refresh_rate;
+      //  Refresh rate not known, allow up to four frames per tick.
+      return build_options.ticks_per_sec * 4.0;
+    };
+
+    //  Earliest time the next frame can be drawn.
+    static double next_frame_time(void) {
+      return last_frame_time + 1.0 / frame_rate();
+    };
+
+    //  Check if a frame should be drawn now.
+    static bool frame_due(void) {
+      return (redraw || animating()) && al_get_time() >= next_frame_time();
+    };
+
+    //  Get the next event, waiting until one arrives or the next frame is due.
+    static bool wait_for_event(ALLEGRO_EVENT& event) {
+      #if defined(__EMSCRIPTEN__)
+        //  The browser paces the loop, never block.
+        return al_get_next_event(main_event_queue, &event);
+      #else
+        //  Nothing to draw, sleep until something happens.
+        //  Wake once a tick's time anyway, so scene code can run while paused.
+        const double wait = (!redraw && !animating() ?
+          1.0 / build_options.ticks_per_sec : next_frame_time() - al_get_time());
+        if (wait <= 0.0) return al_get_next_event(main_event_queue, &event);
+        ALLEGRO_TIMEOUT timeout;
+        al_init_timeout(&timeout, wait);
+        return al_wait_for_event_until(main_event_queue, &event, &timeout);
+      #endif
+    };
+
     static void stop(void) {
       current_scene->unload();
       
@@ -145,6 +384,18 @@ class engine final : public config, public input, public display {
     //  Allegro objects used by the engine.
     inline static ALLEGRO_TIMER* main_timer = NULL;
     inline static ALLEGRO_EVENT_QUEUE* main_event_queue = NULL;
+    //  Time the last tick was due.
+    inline static double last_tick_time = 0.0;
+    //  Time the last frame was drawn.
+    inline static double last_frame_time = 0.0;
+    //  Something changed since the last frame was drawn.
+    inline static bool redraw = true;
+    //  Refresh rate of the display, zero if not known.
+    inline static int refresh_rate = 0;
+
+    //  Virtual clock used when headless.
+    inline static double headless_speed = 0.0;
+    inline static std::chrono::steady_clock::time_point next_tick_time;
 
     //  Restrict to one instance of the engine running.
     inline static bool initialized = false;
@@ -187,6 +438,7 @@ class engine final : public config, public input, public display {
       //  Configure display.  Called from display class.
       std::cout << "Configuring display... ";
       create_display(width, height);
+      refresh_rate = al_get_display_refresh_rate(_display);
       std::cout << "OK!\n";
 
       //  Disable pesky screensavers.
@@ -205,19 +457,14 @@ class engine final : public config, public input, public display {
       al_register_event_source(main_event_queue, al_get_display_event_source(_display));
       al_register_event_source(main_event_queue, al_get_timer_event_source(main_timer));
 
-      //  Create the input event queue
-      input::create_event_queue();
+      //  Input is read from the main queue so the loop can sleep on one queue.
+      input::register_event_sources(main_event_queue);
 
       //  Allegro extras
       al_init_primitives_addon();
       if (config::flags::audio_installed) al_init_acodec_addon();
 
-      //  Load systems and prevent further systems from being loaded.
-      std::cout << "Loading systems... ";
-      load_systems();
-      mgr::systems::finalized = true;
-      if (mgr::systems::empty()) throw engine_error("No systems have been loaded!");
-      std::cout << "OK!\n";
+      load_game();
 
       std::cout << "Loading audio... ";
       mgr::audio::initialize();
@@ -231,25 +478,7 @@ class engine final : public config, public input, public display {
       mgr::gfx::renderer::initialize();
       std::cout << "OK!\n";
 
-      //  Engine (system) commands
-      cmds.add("load-script", 1, [](const msg_args& args) {
-        mgr::messages::load_script(args[0]);
-      });
-      cmds.add("load-scene", 1, [](const msg_args& args) {
-        engine::load_scene(args[0]);
-      });
-      cmds.add("enable-input", 0, [](const msg_args& args) {
-        config::flags::input_enabled = true;
-      });
-      cmds.add("disable-input", 0, [](const msg_args& args) {
-        config::flags::input_enabled = false;
-      });
-
-      if constexpr (build_options.debug_mode) {
-        std::cout << "DEBUG MODE --- LOGGING ENABLED\n";
-        mgr::messages::message_log_start();
-        logger::start();
-      }
+      add_commands();
 
       config::flags::engine_paused = false;
       config::_flags::is_running = true;
@@ -257,10 +486,57 @@ class engine final : public config, public input, public display {
 
       al_stop_timer(main_timer);
       al_set_timer_count(main_timer, 0);
-      engine_time::set(al_get_timer_count(main_timer));
+      input::sim_ticks = 0;
+      engine_time::set(input::sim_ticks);
       al_start_timer(main_timer);
     };
 
+    /*!
+     * \brief Initialize the engine without a display, audio or input.
+     *
+     * The world, systems, messages, spawner and scripts run as normal,
+     * with ticks run from a virtual clock instead of the Allegro timer.
+     * Bitmaps are created in memory, so assets load and animations draw to them as normal.
+     * Nothing is drawn to the screen and audio messages are dropped.
+     * Use for soak tests, server side validation and fast forward simulation.
+     *
+     * \param speed Multiple of real time to run at.  Zero runs as fast as possible.
+     */
+    static void initialize_headless(const double& speed = 0.0) {
+      std::cout << "Initializing Silvergun Game Engine (headless)...\n";
+      if (initialized == true) throw engine_error(display::window_title + " already running!");
+      initialized = true;
+      config::_flags::headless = true;
+
+      std::cout << "Loading Allegro Game Library... ";
+      if (!al_init()) throw engine_error("Allegro failed to load!");
+      std::cout << "OK!\n";
+
+      //  The add-ons work without a display when bitmaps are kept in memory.
+      std::cout << "Loading Allegro add-ons... ";
+      if (!al_init_image_addon()) throw engine_error("Failed to load Allegro image addon!");
+      if (!al_init_font_addon()) throw engine_error("Failed to load Allegro font addon!");
+      al_init_primitives_addon();
+      al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+      std::cout << "OK!\n";
+
+      load_game();
+
+      //  Generate Allegro's default font and load into asset mgr.
+      mgr::assets::load<ALLEGRO_FONT>("slv_default_font", make_asset<ALLEGRO_FONT>());
+
+      add_commands();
+
+      config::flags::engine_paused = false;
+      config::_flags::is_running = true;
+      std::cout << "Engine started successfully!\n";
+
+      headless_speed = (speed > 0.0 ? speed : 0.0);
+      input::sim_ticks = 0;
+      engine_time::set(input::sim_ticks);
+      next_tick_time = std::chrono::steady_clock::now();
+    };
+
     /*!
      * \brief De-initialize the engine.
      */
@@ -270,20 +546,23 @@ class engine final : public config, public input, public display {
       config::_flags::is_running = false;
 
       mgr::world::clear();
-      mgr::audio::deinitialize();
-      mgr::gfx::renderer::deinitialize();
+      if (!config::flags::headless) {
+        mgr::audio::deinitialize();
+        mgr::gfx::renderer::deinitialize();
+      }
       mgr::assets::clear_al_objects();
 
       std::cout << "Cleaning up engine objects... ";
-      al_destroy_timer(main_timer);
-      al_destroy_event_queue(main_event_queue);
-      input::destroy_event_queue();
-      destroy_display();
-      al_inhibit_screensaver(false);
+      if (!config::flags::headless) {
+        al_destroy_timer(main_timer);
+        al_destroy_event_queue(main_event_queue);
+        destroy_display();
+        al_inhibit_screensaver(false);
+      }
       std::cout << "OK!\n";
       std::cout << "Stopping Allegro... ";
       al_shutdown_font_addon();
-      if (config::flags::audio_installed) al_uninstall_audio();
+      if (!config::flags::headless && config::flags::audio_installed) al_uninstall_audio();
       al_shutdown_primitives_addon();
       al_uninstall_system();
       std::cout << "OK!\n";
@@ -294,6 +573,7 @@ class engine final : public config, public input, public display {
       }
 
       initialized = false;
+      config::_flags::headless = false;
       std::cout << "Good bye!\n";
     };
 
@@ -311,7 +591,9 @@ class engine final : public config, public input, public display {
     static void load_scene(const std::string& name) {
       if (current_scene != nullptr) current_scene->unload();
       mgr::world::clear();
+      mgr::spawner::clear_pools();
       mgr::messages::clear();
+      symbols::clear();  //  Entity names and message targets from the last scene are gone.
 
       const auto find_scene = [name](const std::shared_ptr<scene>& s) { return s->name == name; };
       if (auto it = std::find_if(scenes.begin(), scenes.end(), find_scene); it != scenes.end()) {
@@ -319,6 +601,7 @@ class engine final : public config, public input, public display {
       } else {
         throw engine_error("Scene " + name + " does not exist!");
       }
+      mgr::systems::enable_only(current_scene->systems);
 
       current_scene->load();
     };
@@ -15,7 +15,9 @@
 #include <functional>
 #include <fstream>
 #include <sstream>
+#include <iterator>
 #include <ctime>
+#include <cstdint>
 
 #include <allegro5/allegro.h>
 
@@ -23,7 +25,9 @@
 #include "silvergun/_globals/_defines.hpp"
 #include "silvergun/_globals/engine_time.hpp"
 #include "silvergun/_globals/handlers.hpp"
+#include "silvergun/_globals/snapshot.hpp"
 #include "silvergun/config.hpp"
+#include "silvergun/mgr/messages.hpp"
 
 namespace slv {
 
@@ -40,21 +44,111 @@ class input {
     void operator=(input const&) = delete;  //  Delete assignment operator.
 
     /*!
-     * \brief Start input recording.
+     * \brief Start recording the session.
+     *
+     * Input events and scripts loaded with the load-script command are recorded with the number of ticks run.
+     * Ticks dropped when the game falls behind are not counted, so a replay runs the same ticks.
+     * Start recording from the same game state the replay will start from, such as just after a scene loads.
+     *
+     * \param fname File to record to.  Replaced if it exists.
+     * \return True if recording started, false if the file could not be opened.
      */
-    static void start_recording(void) {
-      input_event_file.open("input_events", std::ios::binary | std::ofstream::app);
+    static bool start_recording(const std::string& fname = "input_events") {
+      if (config::flags::record_input) stop_recording();
+      input_event_file.open(fname, std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!input_event_file.is_open()) return false;
+
+      snapshot header;
+      header.write<std::uint32_t>(RECORDING_MAGIC);
+      header.write<std::uint32_t>(RECORDING_VERSION);
+      header.write<float>(build_options.ticks_per_sec);
+      header.write<int64_t>(sim_ticks);
+      write_record(header);
       config::_flags::record_input = true;
+      return true;
     };
 
     /*!
-     * \brief Stop input recording.
+     * \brief Stop recording the session.
      */
     static void stop_recording(void) {
-      if (input_event_file.is_open()) input_event_file.close();
+      if (input_event_file.is_open()) {
+        snapshot record;
+        record.write<std::uint8_t>(RECORD_END);
+        record.write<int64_t>(sim_ticks);
+        write_record(record);
+        input_event_file.close();
+      }
       config::_flags::record_input = false;
     };
 
+    /*!
+     * \brief Replay a recorded session.
+     *
+     * Recorded input events and script loads are run again before the same ticks they were recorded before,
+     * counting ticks from when the replay starts.
+     * Live input and load-script commands are ignored until the replay ends.
+     * Display and joystick pointers are not recorded and are replayed as null.
+     * The game must be in the same state the recording started from.
+     *
+     * \param fname Recorded session file.
+     * \return True if the replay started, false if the file could not be read.
+     * \exception engine_exception The file is not a session recording of a supported version.
+     */
+    static bool start_replay(const std::string& fname) {
+      std::ifstream file(fname, std::ios::binary);
+      if (!file.is_open()) return false;
+      snapshot data(std::vector<std::uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+
+      if (data.read<std::uint32_t>() != RECORDING_MAGIC)
+        throw engine_exception("Not a session recording", "Input", 2);
+      if (data.read<std::uint32_t>() != RECORDING_VERSION)
+        throw engine_exception("Unsupported session recording version", "Input", 2);
+      if (data.read<float>() != build_options.ticks_per_sec)
+        throw engine_exception("Session was recorded at a different tick rate", "Input", 2);
+      const int64_t offset = sim_ticks - data.read<int64_t>();
+
+      replay_records.clear();
+      try {
+        while (true) {
+          replay_record r;
+          r.kind = data.read<std::uint8_t>();
+          r.tick = data.read<int64_t>() + offset;
+          if (r.kind == RECORD_EVENT) r.event = read_event(data);
+          else if (r.kind == RECORD_SCRIPT) r.script = data.read_string();
+          replay_records.push_back(r);
+          if (r.kind == RECORD_END) break;
+        }
+      } catch (const engine_exception&) {
+        //  Recording was not stopped, end after the last complete item.
+        replay_record r;
+        r.kind = RECORD_END;
+        r.tick = (replay_records.empty() ? sim_ticks : replay_records.back().tick);
+        replay_records.push_back(r);
+      }
+      replay_pos = 0;
+      replaying = true;
+      return true;
+    };
+
+    /*!
+     * \brief Stop replaying a session.
+     */
+    static void stop_replay(void) {
+      replay_records.clear();
+      replay_pos = 0;
+      replaying = false;
+    };
+
+    /*!
+     * \brief Check if a session is being replayed.
+     * \return True if replaying.
+     */
+    static bool is_replaying(void) { return replaying; };
+
+    //!  Optional:  Called when a replay reaches the end of the recording.
+    inline static std::function<void(void)> on_replay_end = [](){};
+
   protected:
     //  Constructor
     input() {
@@ -167,58 +261,170 @@ class input {
       }
     };
 
-    //  Create the input queue.
-    static void create_event_queue(void) {
-      input_event_queue = al_create_event_queue();
-      if (!input_event_queue) throw engine_error("Failed to create input event queue!");
-
+    //  Add the input event sources to a queue.
+    static void register_event_sources(ALLEGRO_EVENT_QUEUE* queue) {
       if (build_options.keyboard_enabled && config::flags::keyboard_installed)
-        al_register_event_source(input_event_queue, al_get_keyboard_event_source());
+        al_register_event_source(queue, al_get_keyboard_event_source());
       if (build_options.mouse_enabled && config::flags::mouse_installed)
-        al_register_event_source(input_event_queue, al_get_mouse_event_source());
+        al_register_event_source(queue, al_get_mouse_event_source());
       if (build_options.joystick_enabled && config::flags::joystick_installed)
-        al_register_event_source(input_event_queue, al_get_joystick_event_source());
+        al_register_event_source(queue, al_get_joystick_event_source());
       if (build_options.touch_enabled && config::flags::touch_installed)
-        al_register_event_source(input_event_queue, al_get_touch_input_event_source());
+        al_register_event_source(queue, al_get_touch_input_event_source());
+    };
+
+    //  Run the handles for the scope.
+    static void run_scope(const std::size_t& scope, const ALLEGRO_EVENT& event) {
+      switch (scope) {
+        case 0:
+          run_handles<SCOPE_A>(event);
+          break;
+        case 1:
+          run_handles<SCOPE_B>(event);
+          break;
+        case 2:
+          run_handles<SCOPE_C>(event);
+          break;
+      }
+    };
+
+    //  Session recording format.
+    inline static const std::uint32_t RECORDING_MAGIC = 0x52564C53;  //  "SLVR"
+    inline static const std::uint32_t RECORDING_VERSION = 2;
+    //  Kinds of recorded items.
+    inline static const std::uint8_t RECORD_EVENT = 0;
+    inline static const std::uint8_t RECORD_SCRIPT = 1;
+    inline static const std::uint8_t RECORD_END = 2;
+
+    //  Write a record to the recording file.
+    static void write_record(const snapshot& record) {
+      input_event_file.write(reinterpret_cast<const char*>(record.get_data().data()), record.size());
     };
 
-    //  Destroy the input queue.
-    static void destroy_event_queue(void) {
-      al_destroy_event_queue(input_event_queue);
+    //  Record an input event.  Only the fields used by the handlers are written.
+    static void record_event(const int64_t& tick, const ALLEGRO_EVENT& event) {
+      snapshot record;
+      const std::uint32_t type = event.type;
+      if (type == ALLEGRO_EVENT_KEY_DOWN || type == ALLEGRO_EVENT_KEY_UP) {
+        record.write<std::uint8_t>(RECORD_EVENT);
+        record.write<int64_t>(tick);
+        record.write(type);
+        record.write<std::int32_t>(event.keyboard.keycode);
+      } else if (type == ALLEGRO_EVENT_MOUSE_AXES || type == ALLEGRO_EVENT_MOUSE_BUTTON_DOWN ||
+                 type == ALLEGRO_EVENT_MOUSE_BUTTON_UP || type == ALLEGRO_EVENT_MOUSE_WARPED ||
+                 type == ALLEGRO_EVENT_MOUSE_ENTER_DISPLAY || type == ALLEGRO_EVENT_MOUSE_LEAVE_DISPLAY) {
+        record.write<std::uint8_t>(RECORD_EVENT);
+        record.write<int64_t>(tick);
+        record.write(type);
+        const std::int32_t m[] = { event.mouse.x, event.mouse.y, event.mouse.z, event.mouse.w,
+          event.mouse.dx, event.mouse.dy, event.mouse.dz, event.mouse.dw };
+        for (auto& it: m) record.write(it);
+        record.write<std::uint32_t>(event.mouse.button);
+        record.write<float>(event.mouse.pressure);
+      } else if (type == ALLEGRO_EVENT_JOYSTICK_AXIS || type == ALLEGRO_EVENT_JOYSTICK_BUTTON_DOWN ||
+                 type == ALLEGRO_EVENT_JOYSTICK_BUTTON_UP) {
+        record.write<std::uint8_t>(RECORD_EVENT);
+        record.write<int64_t>(tick);
+        record.write(type);
+        record.write<std::int32_t>(event.joystick.stick);
+        record.write<std::int32_t>(event.joystick.axis);
+        record.write<float>(event.joystick.pos);
+        record.write<std::int32_t>(event.joystick.button);
+      } else if (type == ALLEGRO_EVENT_TOUCH_BEGIN || type == ALLEGRO_EVENT_TOUCH_END ||
+                 type == ALLEGRO_EVENT_TOUCH_MOVE || type == ALLEGRO_EVENT_TOUCH_CANCEL) {
+        record.write<std::uint8_t>(RECORD_EVENT);
+        record.write<int64_t>(tick);
+        record.write(type);
+        record.write<std::int32_t>(event.touch.id);
+        record.write<float>(event.touch.x);
+        record.write<float>(event.touch.y);
+        record.write<float>(event.touch.dx);
+        record.write<float>(event.touch.dy);
+        record.write<std::uint8_t>(event.touch.primary);
+      } else return;  //  Not used by the handlers.
+      write_record(record);
     };
 
-    //  Record input events
-    static void record_event(const int64_t& time, const ALLEGRO_EVENT& event) { 
-      input_event_file.write(reinterpret_cast<const char*>(time), sizeof(int64_t));
-      input_event_file.write(reinterpret_cast<const char*>(sizeof(event)), sizeof(std::size_t));
-      input_event_file.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    //  Read an input event written by record_event.
+    static ALLEGRO_EVENT read_event(snapshot& data) {
+      ALLEGRO_EVENT event = {};
+      event.type = data.read<std::uint32_t>();
+      if (event.type == ALLEGRO_EVENT_KEY_DOWN || event.type == ALLEGRO_EVENT_KEY_UP) {
+        event.keyboard.keycode = data.read<std::int32_t>();
+      } else if (event.type == ALLEGRO_EVENT_JOYSTICK_AXIS || event.type == ALLEGRO_EVENT_JOYSTICK_BUTTON_DOWN ||
+                 event.type == ALLEGRO_EVENT_JOYSTICK_BUTTON_UP) {
+        event.joystick.stick = data.read<std::int32_t>();
+        event.joystick.axis = data.read<std::int32_t>();
+        event.joystick.pos = data.read<float>();
+        event.joystick.button = data.read<std::int32_t>();
+      } else if (event.type == ALLEGRO_EVENT_TOUCH_BEGIN || event.type == ALLEGRO_EVENT_TOUCH_END ||
+                 event.type == ALLEGRO_EVENT_TOUCH_MOVE || event.type == ALLEGRO_EVENT_TOUCH_CANCEL) {
+        event.touch.id = data.read<std::int32_t>();
+        event.touch.x = data.read<float>();
+        event.touch.y = data.read<float>();
+        event.touch.dx = data.read<float>();
+        event.touch.dy = data.read<float>();
+        event.touch.primary = data.read<std::uint8_t>();
+      } else {
+        int* m[] = { &event.mouse.x, &event.mouse.y, &event.mouse.z, &event.mouse.w,
+          &event.mouse.dx, &event.mouse.dy, &event.mouse.dz, &event.mouse.dw };
+        for (auto& it: m) *it = data.read<std::int32_t>();
+        event.mouse.button = data.read<std::uint32_t>();
+        event.mouse.pressure = data.read<float>();
+      }
+      return event;
+    };
+
+    //  Record a script load.
+    static void record_script(const std::string& fname) {
+      if (!config::flags::record_input) return;
+      snapshot record;
+      record.write<std::uint8_t>(RECORD_SCRIPT);
+      record.write<int64_t>(sim_ticks);
+      record.write_string(fname);
+      write_record(record);
     };
 
-    //  Check the input queue for events.
-    static void check_events(const std::size_t& scope) {
-      ALLEGRO_EVENT event;
-      while (al_get_next_event(input_event_queue, &event)) {
-        if (config::flags::input_enabled) {
-          //  Record input if enabled.
-          if (config::flags::record_input) record_event(engine_time::check(), event);
-          //  Run the handles
-          switch (scope) {
-            case 0:
-              run_handles<SCOPE_A>(event);
-              break;
-            case 1:
-              run_handles<SCOPE_B>(event);
-              break;
-            case 2:
-              run_handles<SCOPE_C>(event);
-              break;
-          }
+    //  Run the recorded items due before the next tick.
+    static void replay_events(const std::size_t& scope) {
+      while (replaying && replay_pos < replay_records.size() &&
+             replay_records[replay_pos].tick <= sim_ticks) {
+        const replay_record& r = replay_records[replay_pos++];
+        if (r.kind == RECORD_EVENT) {
+          if (config::flags::input_enabled) run_scope(scope, r.event);
+        } else if (r.kind == RECORD_SCRIPT) {
+          mgr::messages::load_script(r.script);
+        } else {
+          stop_replay();
+          on_replay_end();
         }
       }
     };
 
-    inline static ALLEGRO_EVENT_QUEUE* input_event_queue;  //  Input event queue.
-    inline static std::ofstream input_event_file;          //  Event record file.
+    //  Process an input event from the engine's event queue.
+    static void handle_event(const std::size_t& scope, const ALLEGRO_EVENT& event) {
+      if (replaying) return;  //  Live input is ignored while replaying.
+      if (config::flags::input_enabled) {
+        //  Record input if enabled.
+        if (config::flags::record_input) record_event(sim_ticks, event);
+        //  Run the handles
+        run_scope(scope, event);
+      }
+    };
+
+    //  A recorded item to replay.
+    struct replay_record {
+      std::uint8_t kind;    //  Kind of item.
+      int64_t tick;         //  Number of ticks run before the item runs.
+      ALLEGRO_EVENT event;  //  Input event.
+      std::string script;   //  Script file name.
+    };
+
+    inline static std::ofstream input_event_file;             //  Event record file.
+    inline static std::vector<replay_record> replay_records;  //  Items being replayed.
+    inline static std::size_t replay_pos = 0;                 //  Next item to replay.
+    inline static int64_t sim_ticks = 0;                      //  Number of ticks run, not counting dropped ticks.
+    inline static bool replaying = false;                     //  A session is being replayed.
     inline static bool initialized = false;                //  Restrict to one instance.
 };
 
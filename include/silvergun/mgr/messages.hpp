@@ -14,6 +14,7 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <mutex>
 #include <stdexcept>
 #include <fstream>
 
@@ -55,23 +56,15 @@ class messages final : private manager<messages> {
      * Keeps checking for responces and will process as well.
      */
     static void dispatch(void) {
-      component_container<cmp::dispatcher> dispatch_components =
-        mgr::world::set_components<cmp::dispatcher>();
-
       while (true) {  //  Infinite loop to verify all current messages are processed.
         message_container temp_msgs = get("entities");
         if (temp_msgs.empty()) break;  //  No messages, end loop.
 
-        //  For all messages, check each dispatch component.
+        //  For all messages, look up the entity by name and pass to its dispatch component.
         for (auto& m_it: temp_msgs) {
-          for (auto& c_it: dispatch_components) {
-            try {
-              if (m_it.get_to() == mgr::world::get_name(c_it.first)) {
-                c_it.second->handle_msg(c_it.first, m_it);
-                break;  //  Found, stop checking dispatch components.
-              }
-            } catch (...) { break; }  //  Entity not found, just continue.
-          }
+          const entity_id e_id = mgr::world::get_id(m_it.get_to_symbol());
+          if (!mgr::world::has_component<cmp::dispatcher>(e_id)) continue;  //  Entity not found, just continue.
+          mgr::world::set_component<cmp::dispatcher>(e_id)->handle_msg(e_id, m_it);
         }
       }
     };
@@ -201,6 +194,7 @@ class messages final : private manager<messages> {
 
     inline static message_container _messages;   //  Vector of all messages to be processed
     inline static std::ofstream debug_log_file;  //  For message logging
+    inline static std::mutex mtx;                //  Lock for adding messages from multiple threads.
   
   public:
     /*!
@@ -211,6 +205,7 @@ class messages final : private manager<messages> {
      * \param msg Message to add.
      */
     static void add(const message& msg) {
+      std::lock_guard<std::mutex> lock(mtx);
       _messages.insert(_messages.begin(), msg);
       if (msg.is_timed_event()) std::sort(_messages.begin(), _messages.end());
     };
@@ -10,7 +10,9 @@
 
 #include <string>
 #include <utility>
-#include <set>
+#include <tuple>
+#include <vector>
+#include <algorithm>
 #include <iterator>
 #include <functional>
 #include <memory>
@@ -52,7 +54,7 @@ namespace slv::mgr::gfx {
  * \tparam Component type
  */
 template <typename T>
-using entity_component_pair = std::pair<const entity_id, std::shared_ptr<const T>>;
+using entity_component_pair = std::pair<entity_id, const T*>;
 
 /*!
  * \class renderer
@@ -97,36 +99,35 @@ class renderer final : private manager<renderer> {
     
     //  Draw hitboxes if debug mode is enabled.
     static void draw_hitboxes(void) {
-      const const_component_container<cmp::hitbox> hitbox_components =
-        mgr::world::get_components<cmp::hitbox>();
-
-      for (auto& it: hitbox_components) {
-        if (it.second->solid) {
+      for (auto [e_id, box, loc]: mgr::world::query<const cmp::hitbox, const cmp::location>()) {
+        if (box.solid) {
+          const float pos_x = blend(loc.prev_x, loc.pos_x);
+          const float pos_y = blend(loc.prev_y, loc.pos_y);
           //  Select color based on team.
           ALLEGRO_COLOR team_color;
-          switch(it.second->team) {
+          switch(box.team) {
             case 0: team_color = al_map_rgb(0,255,0); break;
             case 1: team_color = al_map_rgb(255,0,0); break;
             case 2: team_color = al_map_rgb(0,0,255); break;
             default: team_color = al_map_rgb(255,255,0);
           }
           //  Draw the hitbox.
-          ALLEGRO_BITMAP* temp_bitmap = al_create_bitmap(
-            it.second->width,
-            it.second->height);
+          ALLEGRO_BITMAP* temp_bitmap = al_create_bitmap(box.width, box.height);
           al_set_target_bitmap(temp_bitmap);
           al_clear_to_color(team_color);
           al_set_target_bitmap(viewport_bitmap.get());
-          try {
-            al_draw_bitmap(temp_bitmap,
-              mgr::world::get_component<cmp::location>(it.first)->pos_x,
-              mgr::world::get_component<cmp::location>(it.first)->pos_y, 0);
-          } catch(const std::exception& e) { throw e; }
+          al_draw_bitmap(temp_bitmap, pos_x, pos_y, 0);
           al_destroy_bitmap(temp_bitmap);
         }
       }
     };
     
+    //  Blend a position between the last two ticks.
+    static float blend(const float& prev, const float& current) {
+      if (!config::sim::interpolate) return current;
+      return prev + (current - prev) * _alpha;
+    };
+
     //  Draw time if debug mode is enabled.
     static void draw_timer(void) {
       if constexpr (build_options.debug_mode) {
@@ -135,11 +136,30 @@ class renderer final : private manager<renderer> {
       }
     };
 
-    //  For sorting.
-    template <typename T> struct comparator {
-      bool operator() (const T& a, const T& b) const {
-        return *a.second < *b.second;
-      }
+    //  For sorting.  Order by layer, then by entity ID, so the order on a layer
+    //  does not change when components move around in their pool.
+    static bool draw_order(
+      const cmp::gfx::gfx& a, const entity_id& a_id,
+      const cmp::gfx::gfx& b, const entity_id& b_id
+    ) {
+      if (a < b) return true;
+      if (b < a) return false;
+      return a_id < b_id;
+    };
+
+    //  Copy a component container into a buffer and sort by layer.
+    //  The buffer is reused each frame to avoid allocating.
+    template <typename T>
+    static void sort_layers(
+      const const_component_container<T>& components,
+      std::vector<entity_component_pair<T>>& buffer
+    ) {
+      buffer.clear();
+      for (auto& it: components) buffer.push_back(it);
+      std::sort(buffer.begin(), buffer.end(),
+        [](const entity_component_pair<T>& a, const entity_component_pair<T>& b) {
+          return draw_order(*a.second, a.first, *b.second, b.first);
+        });
     };
 
     //  Draw the game screen.
@@ -172,12 +192,10 @@ class renderer final : private manager<renderer> {
         mgr::world::get_components<cmp::gfx::background>();
 
       //  Sort the background layers.
-      std::multiset<entity_component_pair<cmp::gfx::background>,
-        comparator<entity_component_pair<cmp::gfx::background>>> background_componenet_set(
-        background_components.begin(), background_components.end());
+      sort_layers(background_components, background_buffer);
 
       //  Draw each background by layer.
-      for (auto& it: background_componenet_set) {
+      for (auto& it: background_buffer) {
         if (it.second->visible) {
           float angle = 0.0f;
           float center_x = 0.0f, center_y = 0.0f;
@@ -216,63 +234,67 @@ class renderer final : private manager<renderer> {
         }
       }
 
-      //  Draw the sprites.
-      const const_component_container<cmp::gfx::sprite> sprite_components =
-        mgr::world::get_components<cmp::gfx::sprite>();
+      //  Draw the sprites.  Get each sprite with its location.
+      sprite_buffer.clear();
+      for (auto [e_id, spr, loc]: mgr::world::query<const cmp::gfx::sprite, const cmp::location>())
+        sprite_buffer.emplace_back(e_id, &loc, &spr);
 
       //  Sort the sprite components.
-      std::multiset<entity_component_pair<cmp::gfx::sprite>,
-        comparator<entity_component_pair<cmp::gfx::sprite>>> sprite_componenet_set(
-        sprite_components.begin(), sprite_components.end());
+      std::sort(sprite_buffer.begin(), sprite_buffer.end(),
+        [](const sprite_entry& a, const sprite_entry& b) {
+          return draw_order(*std::get<2>(a), std::get<0>(a), *std::get<2>(b), std::get<0>(b));
+        });
 
       //  Draw each sprite in order.
-      for (auto& it: sprite_componenet_set) {
-        if (it.second->visible) {
+      for (auto& [e_id, loc, spr]: sprite_buffer) {
+        if (spr->visible) {
           //  Get the current sprite frame.
           ALLEGRO_BITMAP* temp_bitmap = al_create_sub_bitmap(
-            it.second->_bitmap.get(),
-            it.second->sprite_x,
-            it.second->sprite_y,
-            it.second->sprite_width,
-            it.second->sprite_height
+            spr->_bitmap.get(),
+            spr->sprite_x,
+            spr->sprite_y,
+            spr->sprite_width,
+            spr->sprite_height
           );
 
           float angle = 0.0f;
           float center_x = 0.0f, center_y = 0.0f;
           float destination_x = 0.0f, destination_y = 0.0f;
-          cmp::const_comp_ptr<cmp::location> temp_get = mgr::world::get_component<cmp::location>(it.first);
+          const cmp::location* temp_get = loc;
+          const float pos_x = blend(temp_get->prev_x, temp_get->pos_x);
+          const float pos_y = blend(temp_get->prev_y, temp_get->pos_y);
 
           //  Check if the sprite should be rotated.
-          if (it.second->rotated) {
-            angle = it.second->direction;
+          if (spr->rotated) {
+            angle = spr->direction;
             center_x = (al_get_bitmap_width(temp_bitmap) / 2);
             center_y = (al_get_bitmap_height(temp_bitmap) / 2);
 
-            destination_x = temp_get->pos_x +
-              (al_get_bitmap_width(temp_bitmap) * it.second->scale_factor_x / 2) +
-              (it.second->draw_offset_x * it.second->scale_factor_x);
-            destination_y = temp_get->pos_y +
-              (al_get_bitmap_height(temp_bitmap) * it.second->scale_factor_y / 2) +
-              (it.second->draw_offset_y * it.second->scale_factor_y);
+            destination_x = pos_x +
+              (al_get_bitmap_width(temp_bitmap) * spr->scale_factor_x / 2) +
+              (spr->draw_offset_x * spr->scale_factor_x);
+            destination_y = pos_y +
+              (al_get_bitmap_height(temp_bitmap) * spr->scale_factor_y / 2) +
+              (spr->draw_offset_y * spr->scale_factor_y);
           } else {
-            destination_x = temp_get->pos_x + it.second->draw_offset_x;
-            destination_y = temp_get->pos_y + it.second->draw_offset_y;
+            destination_x = pos_x + spr->draw_offset_x;
+            destination_y = pos_y + spr->draw_offset_y;
           }
 
           //  Draw the sprite.
-          if (it.second->tinted)
+          if (spr->tinted)
             al_draw_tinted_scaled_rotated_bitmap(
-                temp_bitmap, it.second->get_tint(),
+                temp_bitmap, spr->get_tint(),
                 center_x, center_y, destination_x, destination_y,
-                it.second->scale_factor_x,
-                it.second->scale_factor_y,
+                spr->scale_factor_x,
+                spr->scale_factor_y,
                 angle, 0
             );
           else
             al_draw_scaled_rotated_bitmap(
                 temp_bitmap, center_x, center_y, destination_x, destination_y,
-                it.second->scale_factor_x,
-                it.second->scale_factor_y,
+                spr->scale_factor_x,
+                spr->scale_factor_y,
                 angle, 0
             );
 
@@ -289,12 +311,10 @@ class renderer final : private manager<renderer> {
         mgr::world::get_components<cmp::gfx::overlay>();
 
       //  Sort the overlay layers.
-      std::multiset<entity_component_pair<cmp::gfx::overlay>,
-        comparator<entity_component_pair<cmp::gfx::overlay>>> overlay_componenet_set(
-        overlay_components.begin(), overlay_components.end());
+      sort_layers(overlay_components, overlay_buffer);
 
       //  Draw each overlay by layer.
-      for (auto& it: overlay_componenet_set) {
+      for (auto& it: overlay_buffer) {
         if (it.second->visible) {
           float angle = 0.0f;
           float center_x = 0.0f, center_y = 0.0f;
@@ -355,6 +375,13 @@ class renderer final : private manager<renderer> {
       _last_render = system_clock::now();
     }
 
+    //  Buffers for sorting components by layer.
+    inline static std::vector<entity_component_pair<cmp::gfx::background>> background_buffer;
+    //  A sprite with its entity and location.
+    using sprite_entry = std::tuple<entity_id, const cmp::location*, const cmp::gfx::sprite*>;
+    inline static std::vector<sprite_entry> sprite_buffer;
+    inline static std::vector<entity_component_pair<cmp::gfx::overlay>> overlay_buffer;
+
     inline static ALLEGRO_TIMER* fps_timer = NULL;
     inline static ALLEGRO_EVENT_QUEUE* fps_event_queue = NULL;
     inline static ALLEGRO_EVENT fps_event;
@@ -363,6 +390,7 @@ class renderer final : private manager<renderer> {
     inline static slv_asset<ALLEGRO_FONT> renderer_font = nullptr;
 
     inline static std::size_t fps_counter = 0, _fps = 0;
+    inline static float _alpha = 1.0f;
     inline static time_point<system_clock> _last_render, _start_time;
     inline static duration _delta_time;
 
@@ -412,6 +440,7 @@ class renderer final : private manager<renderer> {
     inline static const time_point<system_clock>& last_render = _last_render;  //!<  Point in time last render completed
     inline static const time_point<system_clock>& start_time = _start_time;    //!<  Point in time the renderer started
     inline static const duration& delta_time = _delta_time;                    //!<  Time between frame renders
+    inline static const float& alpha = _alpha;                                 //!<  Time since the last tick as a fraction of a tick
 
 };
 
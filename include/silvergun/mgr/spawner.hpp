@@ -11,17 +11,172 @@
 #include <string>
 #include <utility>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <functional>
+#include <algorithm>
+#include <tuple>
 
 #include "silvergun/mgr/manager.hpp"
 
 #include "silvergun/_globals/message.hpp"
+#include "silvergun/_globals/type_id.hpp"
 #include "silvergun/mgr/world.hpp"
 
 namespace slv {
   class engine;
 }
 
+namespace slv {
+
+/*!
+ * \class prefab
+ * \brief Blueprint of components for creating entities.
+ *
+ * Stores the constructor arguments for each component,
+ * so assets are looked up and values worked out once when the prefab is built.
+ * Creating an entity from the prefab only constructs the components.
+ */
+class prefab final {
+  private:
+    //  Creates one component type for an entity.
+    struct builder {
+      std::size_t type;                                //  Component or tag type, IDs shared by both.
+      const void* store;                               //  World storage for the type.
+      std::function<void(const entity_id&)> build;     //  Add the component to an entity.
+      std::function<bool(const entity_id&)> rebuild;   //  Rebuild a deactivated entity's component in place.
+      std::function<void(const std::size_t&)> reserve; //  Make room for components.
+    };
+
+    std::vector<builder> builders;  //  Components in the order they were added.
+
+    //  Add or replace a builder by type.
+    void set_builder(builder&& b) {
+      for (auto& it: builders) {
+        if (it.type == b.type) {
+          it = std::move(b);
+          return;
+        }
+      }
+      builders.push_back(std::move(b));
+    };
+
+  public:
+    prefab() = default;   //  Default constructor.
+    ~prefab() = default;  //  Default destructor.
+
+    /*!
+     * \brief Add a component to the prefab.
+     *
+     * Replaces any component of the same type already in the prefab.
+     *
+     * \tparam T Component type.
+     * \param args Arguments to pass to the component constructor.
+     * \return Reference to the prefab, so calls can be chained.
+     */
+    template <typename T, typename... Args>
+    prefab& add(Args... args) {
+      set_builder({
+        type_id<prefab>::get<T>(),
+        static_cast<const component_storage*>(&mgr::world::pool<T>()),
+        [stored = std::make_tuple(args...)](const entity_id& e_id) {
+          std::apply([&e_id](const auto&... a) { mgr::world::add_component<T>(e_id, a...); }, stored);
+        },
+        [stored = std::make_tuple(args...)](const entity_id& e_id) {
+          return std::apply([&e_id](const auto&... a) { return mgr::world::reconstruct<T>(e_id, a...); }, stored);
+        },
+        [](const std::size_t& n) { mgr::world::reserve<T>(n); }
+      });
+      return *this;
+    };
+
+    /*!
+     * \brief Add a tag to the prefab.
+     * \tparam T Tag type.
+     * \return Reference to the prefab, so calls can be chained.
+     */
+    template <typename T>
+    prefab& tag(void) {
+      set_builder({
+        type_id<prefab>::get<T>(),
+        &mgr::world::tags<T>(),
+        [](const entity_id& e_id) { mgr::world::add_tag<T>(e_id); },
+        [](const entity_id&) { return false; },
+        [](const std::size_t&) {}
+      });
+      return *this;
+    };
+
+    /*!
+     * \brief Give an entity the prefab's components.
+     * \param e_id Entity ID.
+     * \param overrides Components to use instead of the prefab's components of the same type.
+     */
+    void build(const entity_id& e_id, const prefab& overrides) const {
+      for (auto& it: builders) {
+        const auto o_it = std::find_if(overrides.builders.begin(), overrides.builders.end(),
+          [&it](const builder& o) { return o.type == it.type; });
+        if (o_it == overrides.builders.end()) it.build(e_id);
+        else o_it->build(e_id);
+      }
+      //  Overrides of types not in the prefab are added as well.
+      for (auto& o_it: overrides.builders) {
+        const auto it = std::find_if(builders.begin(), builders.end(),
+          [&o_it](const builder& b) { return b.type == o_it.type; });
+        if (it == builders.end()) o_it.build(e_id);
+      }
+    };
+
+    /*!
+     * \brief Give an entity the prefab's components.
+     * \param e_id Entity ID.
+     */
+    void build(const entity_id& e_id) const {
+      for (auto& it: builders) it.build(e_id);
+    };
+
+    /*!
+     * \brief Reset a deactivated entity built from the prefab.
+     *
+     * Components the entity still has are constructed again,
+     * in their existing memory if the constructor cannot throw.
+     * Any that are missing are added.
+     * Components and tags it was given that are not in the prefab or the overrides are dropped.
+     *
+     * \param e_id Entity ID, must be deactivated.
+     * \param overrides Components to use instead of the prefab's components of the same type.
+     */
+    void rebuild(const entity_id& e_id, const prefab& overrides) const {
+      std::vector<const void*> keep;
+      for (auto& it: builders) keep.push_back(it.store);
+      for (auto& it: overrides.builders) keep.push_back(it.store);
+      mgr::world::trim_stash(e_id, keep);
+
+      const auto rebuild_one = [&e_id](const builder& b) { if (!b.rebuild(e_id)) b.build(e_id); };
+      for (auto& it: builders) {
+        const auto o_it = std::find_if(overrides.builders.begin(), overrides.builders.end(),
+          [&it](const builder& o) { return o.type == it.type; });
+        rebuild_one(o_it == overrides.builders.end() ? it : *o_it);
+      }
+      for (auto& o_it: overrides.builders) {
+        const auto it = std::find_if(builders.begin(), builders.end(),
+          [&o_it](const builder& b) { return b.type == o_it.type; });
+        if (it == builders.end()) rebuild_one(o_it);
+      }
+    };
+
+    /*!
+     * \brief Make room for a number of entities built from the prefab.
+     * \param n Number of entities.
+     */
+    void reserve(const std::size_t& n) const {
+      mgr::world::reserve(n);
+      for (auto& it: builders) it.reserve(n);
+    };
+};
+
+}
+
 namespace slv::mgr {
 
 /*!
@@ -37,8 +192,19 @@ class spawner final : private manager<spawner> {
 
     //  Takes spawner messages and processes.
     static void process_messages(const message_container& messages) {
+      //  Make room for all entities spawned this tick at once.
+      const std::size_t spawn_count = std::count_if(messages.begin(), messages.end(),
+        [](const message& m){ return m.get_cmd() == "new"; });
+      if (spawn_count > 1) mgr::world::reserve(spawn_count);
+
       for (auto& m_it: messages) {
         if (m_it.get_cmd() == "new") {
+          //  Prefabs take no arguments.  Spawned the same way as spawn_prefab, so pools are used.
+          if (m_it.num_args() == 1 && prefabs.find(m_it.get_arg(0)) != prefabs.end()) {
+            spawn_prefab(m_it.get_arg(0));
+            continue;
+          }
+
           auto s_it = spawns.find(m_it.get_arg(0));
           if (s_it != spawns.end())
             //  Make sure the number of arguments match what's expected.
@@ -53,7 +219,7 @@ class spawner final : private manager<spawner> {
         if (m_it.get_cmd() == "delete") {
           entity_id delete_entity_id = mgr::world::get_id(m_it.get_arg(0));
           if (delete_entity_id != slv::mgr::ENTITY_ERROR) {
-            mgr::world::delete_entity(delete_entity_id);
+            release(delete_entity_id);  //  Pooled entities are kept for reuse.
           }
         }
       }
@@ -65,6 +231,40 @@ class spawner final : private manager<spawner> {
         const std::size_t,
         const std::function<void(const entity_id&, const msg_args&)>>> spawns;
 
+    inline static std::map<const std::string, const prefab> prefabs;  //  Prefabs by name.
+
+    //  Deactivated entities ready for reuse, by prefab name.
+    inline static std::map<const std::string, std::vector<entity_id>> entity_pools;
+    //  Entities spawned from pooled prefabs, with the pool they return to.
+    inline static std::unordered_map<entity_id, std::vector<entity_id>*> pooled_entities;
+
+    //  Number of world snapshot restores when the pools were last checked.
+    inline static std::size_t restore_count = 0;
+
+    //  Clear the entity pools.  Called when the world is cleared.
+    static void clear_pools(void) {
+      for (auto& it: entity_pools) it.second.clear();
+      pooled_entities.clear();
+      restore_count = mgr::world::restore_count;
+    };
+
+    //  Rebuild the entity pools if a snapshot was restored.
+    //  Pooled entities from the snapshot come back deactivated and are free again,
+    //  those the snapshot does not have are dropped.
+    static void check_restored(void) {
+      if (restore_count == mgr::world::restore_count) return;
+      restore_count = mgr::world::restore_count;
+      for (auto& it: entity_pools) it.second.clear();
+      for (auto it = pooled_entities.begin(); it != pooled_entities.end();) {
+        if (!mgr::world::entity_exists(it->first)) {
+          it = pooled_entities.erase(it);
+          continue;
+        }
+        if (!mgr::world::is_active(it->first)) it->second->push_back(it->first);
+        it++;
+      }
+    };
+
   public:
     /*!
      * \brief Add a spawn to the spawner map.
@@ -118,6 +318,172 @@ class spawner final : private manager<spawner> {
       }
       return false;
     };
+
+    /*!
+     * \brief Spawn a number of entities of the same kind at once.
+     *
+     * Room for all the entities is reserved before any are created.
+     *
+     * \param name Name of entity to spawn.
+     * \param args Arguments to each entity's creation.
+     * \return Number of entities spawned.
+     */
+    static std::size_t spawn_batch(const std::string& name, const std::vector<msg_args>& args) {
+      auto it = spawns.find(name);
+      if (it == spawns.end()) return 0;
+
+      mgr::world::reserve(args.size());
+      std::size_t count = 0;
+      for (auto& a_it: args) {
+        if (a_it.size() != it->second.first) continue;
+        const entity_id e_id = mgr::world::new_entity();
+        if (e_id == mgr::ENTITY_ERROR) break;
+        it->second.second(e_id, a_it);
+        count++;
+      }
+      return count;
+    };
+
+    /*!
+     * \brief Add a prefab.
+     *
+     * Prefabs can also be spawned by "new" spawner messages with no arguments.
+     *
+     * \param name Reference name for the prefab.
+     * \param p Prefab to store.
+     * \return True if added, false if the name is already in use.
+     */
+    static bool add_prefab(const std::string& name, const prefab& p) {
+      return prefabs.insert(std::make_pair(name, p)).second;
+    };
+
+    /*!
+     * \brief Delete a prefab.
+     * \param name Name of prefab to delete.
+     * \return True if removed, else false.
+     */
+    static bool remove_prefab(const std::string& name) {
+      return (prefabs.erase(name) > 0);
+    };
+
+    /*!
+     * \brief Spawn an entity from a prefab.
+     * \param name Name of the prefab.
+     * \return The new entity ID, ENTITY_ERROR if the prefab does not exist.
+     */
+    static entity_id spawn_prefab(const std::string& name) {
+      return spawn_prefab(name, prefab());
+    };
+
+    /*!
+     * \brief Spawn an entity from a prefab, replacing some of its components.
+     * \param name Name of the prefab.
+     * \param overrides Components to use instead of the prefab's components of the same type.
+     * \return The new entity ID, ENTITY_ERROR if the prefab does not exist.
+     */
+    static entity_id spawn_prefab(const std::string& name, const prefab& overrides) {
+      auto it = prefabs.find(name);
+      if (it == prefabs.end()) return mgr::ENTITY_ERROR;
+      check_restored();
+
+      auto p_it = entity_pools.find(name);
+      if (p_it != entity_pools.end()) {
+        //  Reuse a pooled entity if one is free.
+        //  Entities released while the world is locked are not free until it unlocks.
+        std::vector<entity_id>& pool = p_it->second;
+        for (std::size_t i = pool.size(); i > 0; i--) {
+          const entity_id e_id = pool[i - 1];
+          if (!mgr::world::entity_exists(e_id)) {  //  Deleted outside the spawner, drop it.
+            pool.erase(pool.begin() + (i - 1));
+            pooled_entities.erase(e_id);
+            continue;
+          }
+          if (mgr::world::is_active(e_id)) continue;
+          //  Left in the pool if a component constructor throws.
+          it->second.rebuild(e_id, overrides);
+          pool.erase(pool.begin() + (i - 1));
+          mgr::world::activate(e_id);
+          return e_id;
+        }
+      }
+
+      const entity_id e_id = mgr::world::new_entity();
+      if (e_id == mgr::ENTITY_ERROR) return e_id;
+      it->second.build(e_id, overrides);
+      if (p_it != entity_pools.end()) pooled_entities.insert(std::make_pair(e_id, &p_it->second));
+      return e_id;
+    };
+
+    /*!
+     * \brief Spawn a number of entities from a prefab at once.
+     *
+     * Room for the entities and all of their components is reserved first.
+     *
+     * \param name Name of the prefab.
+     * \param count Number of entities to spawn.
+     * \return The new entity IDs, empty if the prefab does not exist.
+     */
+    static std::vector<entity_id> spawn_prefab(const std::string& name, const std::size_t& count) {
+      auto it = prefabs.find(name);
+      if (it == prefabs.end()) return {};
+
+      it->second.reserve(count);
+      std::vector<entity_id> temp_vec;
+      temp_vec.reserve(count);
+      for (std::size_t i = 0; i < count; i++) {
+        const entity_id e_id = spawn_prefab(name, prefab());
+        if (e_id == mgr::ENTITY_ERROR) break;
+        temp_vec.push_back(e_id);
+      }
+      return temp_vec;
+    };
+
+    /*!
+     * \brief Keep entities spawned from a prefab for reuse.
+     *
+     * Released entities from the prefab are deactivated instead of deleted.
+     * Spawning the prefab again reuses them, constructing their components
+     * again in the same memory.
+     * Pooled entities keep their entity ID and name between uses.
+     *
+     * \param name Name of the prefab.
+     * \param count Number of entities to create in the pool now.
+     * \return True if pooling was enabled, false if the prefab does not exist.
+     */
+    static bool enable_pool(const std::string& name, const std::size_t& count) {
+      auto it = prefabs.find(name);
+      if (it == prefabs.end()) return false;
+
+      check_restored();
+      std::vector<entity_id>& pool = entity_pools[name];
+      it->second.reserve(count);
+      pool.reserve(pool.size() + count);
+      for (const entity_id& e_id: mgr::world::create_entities(count)) {
+        it->second.build(e_id);
+        mgr::world::deactivate(e_id);
+        pool.push_back(e_id);
+        pooled_entities.insert(std::make_pair(e_id, &pool));
+      }
+      return true;
+    };
+
+    /*!
+     * \brief Release an entity.
+     *
+     * Entities spawned from a pooled prefab are deactivated and returned to the pool.
+     * Other entities are deleted.
+     *
+     * \param e_id Entity ID to release.
+     * \return True if released, false if the entity does not exist.
+     */
+    static bool release(const entity_id& e_id) {
+      check_restored();
+      auto it = pooled_entities.find(e_id);
+      if (it == pooled_entities.end()) return mgr::world::delete_entity(e_id);
+      if (!mgr::world::deactivate(e_id)) return false;
+      it->second->push_back(e_id);
+      return true;
+    };
 };
 
 template <> bool manager<spawner>::initialized = false;
@@ -12,10 +12,17 @@
 #include <vector>
 #include <iterator>
 #include <memory>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 
 #include "silvergun/mgr/manager.hpp"
 
 #include "silvergun/_debug/exceptions.hpp"
+#include "silvergun/_debug/profiler.hpp"
+#include "silvergun/_globals/job_pool.hpp"
+#include "silvergun/_globals/type_id.hpp"
 #include "silvergun/sys/system.hpp"
 
 namespace slv {
@@ -38,24 +45,92 @@ class systems final : private manager<systems> {
     //  Clear the system manager and allow systems to be loaded again.
     static void clear(void) {
       _systems.clear();
+      stages.clear();
+      stages_dirty = false;
+      tick = 0;
       finalized = false;
     };
 
     //  Check if systems were loaded into the manager.
     static bool empty(void) { return (_systems.empty()); };
 
-    //  Run all systems.
+    /*
+     * Group the systems into stages that run one after another.
+     * Each system goes in the stage after the last one holding an earlier system it conflicts with,
+     * so conflicting systems keep the order they were added in.
+     */
+    static void build_stages(void) {
+      stages.clear();
+      stages_dirty = false;
+      std::vector<std::size_t> stage_of;
+      for (std::size_t i = 0; i < _systems.size(); i++) {
+        std::size_t s = 0;
+        for (std::size_t j = 0; j < i; j++)
+          if (_systems[i]->conflicts(*_systems[j]) && stage_of[j] + 1 > s) s = stage_of[j] + 1;
+        stage_of.push_back(s);
+        if (s == stages.size()) stages.emplace_back();
+        stages[s].push_back(_systems[i].get());
+        if constexpr (build_options.profiler_enabled) profiler::add(_systems[i]->name);
+      }
+    };
+
+    //  Run a system, timing it if the profiler is enabled.
+    static void run_system(sys::system* s) {
+      if constexpr (build_options.profiler_enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        s->run();
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        profiler::record(s->name, elapsed.count());
+      } else s->run();
+    };
+
+    //  Run all systems due on this tick.
     static void run(void) {
-      for (auto& it: _systems)
-        try { 
-          (it)->run();
-        } catch (const std::exception& e) { throw e; }
+      if (stages_dirty || (stages.empty() && !_systems.empty())) build_stages();
+      std::vector<sys::system*> due;
+      for (auto& stage: stages) {
+        due.clear();
+        for (auto& it: stage) if (it->due(tick)) due.push_back(it);
+        if (due.empty()) continue;
+        if (due.size() == 1) {
+          try {
+            run_system(due.front());
+          } catch (const std::exception& e) { throw e; }
+          continue;
+        }
+        //  Run the systems in the stage on the job pool.
+        std::vector<std::function<void(void)>> jobs;
+        jobs.reserve(due.size());
+        for (auto& it: due) jobs.push_back([it](){ run_system(it); });
+        job_pool::run(jobs);
+      }
+      tick++;
     };
 
     // Store the vector of systems.
     inline static std::vector<sys::system_uptr> _systems;
+    //  Systems grouped into stages that can run in parallel.
+    inline static std::vector<std::vector<sys::system*>> stages;
     //  Flag to disallow loading of additional systems.
     inline static bool finalized = false;
+    //  Number of times the systems have been run.
+    inline static std::uint64_t tick = 0;
+    //  Flag to rebuild the stages before the next run.
+    inline static bool stages_dirty = false;
+
+    //  Find a system by type.
+    template <typename T>
+    static sys::system* find(void) {
+      const std::size_t type = type_id<sys::system>::get<T>();
+      for (auto& it: _systems) if (it->type == type) return it.get();
+      return nullptr;
+    };
+
+    //  Find a system by name.
+    static sys::system* find(const std::string& name) {
+      for (auto& it: _systems) if (it->name == name) return it.get();
+      return nullptr;
+    };
 
   public:
     /*!
@@ -63,6 +138,8 @@ class systems final : private manager<systems> {
      * 
      * Enters system into the vector of systems.
      * Systems run in the order they were added.
+     * Systems that declare their components may run at the same time as
+     * earlier or later systems they do not conflict with.
      * Can fail if the system exists or if the game is running.
      *
      * \param new_system System to add.
@@ -71,11 +148,124 @@ class systems final : private manager<systems> {
     template <typename T, typename... Args>
     static bool add(Args... args) {
       if (finalized == true) return false;
+      const std::size_t type = type_id<sys::system>::get<T>();
       for (auto& it: _systems) {
-        auto& r = *it.get();
-        if (typeid(r) == typeid(T)) return false;
+        if (it->type == type) return false;
       }
       _systems.push_back(std::make_unique<T>(args...));
+      _systems.back()->type = type;
+      stages.clear();
+      return true;
+    };
+
+    /*!
+     * \brief Set how often a system runs.
+     *
+     * Systems with the same interval and different phases run on different ticks,
+     * spreading their work out.
+     *
+     * \tparam T System type.
+     * \param interval Run every this many ticks.  Zero or one runs every tick.
+     * \param phase Tick within the interval to run on.
+     * \return True if set, false if the system was not found.
+     */
+    template <typename T>
+    static bool set_interval(const std::size_t& interval, const std::size_t& phase) {
+      sys::system* s = find<T>();
+      if (s == nullptr) return false;
+      s->run_every(interval, phase);
+      return true;
+    };
+
+    /*!
+     * \brief Enable a system so it runs again.
+     * \tparam T System type.
+     * \return True if found, false if not.
+     */
+    template <typename T>
+    static bool enable(void) {
+      sys::system* s = find<T>();
+      if (s == nullptr) return false;
+      s->enabled = true;
+      return true;
+    };
+
+    /*!
+     * \brief Enable a system so it runs again.
+     * \param name System name.
+     * \return True if found, false if not.
+     */
+    static bool enable(const std::string& name) {
+      sys::system* s = find(name);
+      if (s == nullptr) return false;
+      s->enabled = true;
+      return true;
+    };
+
+    /*!
+     * \brief Disable a system so it is skipped until enabled.
+     * \tparam T System type.
+     * \return True if found, false if not.
+     */
+    template <typename T>
+    static bool disable(void) {
+      sys::system* s = find<T>();
+      if (s == nullptr) return false;
+      s->enabled = false;
+      return true;
+    };
+
+    /*!
+     * \brief Disable a system so it is skipped until enabled.
+     * \param name System name.
+     * \return True if found, false if not.
+     */
+    static bool disable(const std::string& name) {
+      sys::system* s = find(name);
+      if (s == nullptr) return false;
+      s->enabled = false;
+      return true;
+    };
+
+    /*!
+     * \brief Check if a system is enabled.
+     * \param name System name.
+     * \return True if the system exists and is enabled, false if not.
+     */
+    static bool is_enabled(const std::string& name) {
+      sys::system* s = find(name);
+      return (s != nullptr && s->enabled);
+    };
+
+    /*!
+     * \brief Enable only the named systems and disable the rest.
+     * \param names Names of the systems to run.  If empty all systems are enabled.
+     */
+    static void enable_only(const std::vector<std::string>& names) {
+      for (auto& it: _systems)
+        it->enabled = (names.empty() || std::find(names.begin(), names.end(), it->name) != names.end());
+    };
+
+    /*!
+     * \brief Move a system to a new position in the run order.
+     *
+     * Takes effect from the next tick.
+     *
+     * \tparam T System type.
+     * \param pos New position, past the end moves the system last.
+     * \return True if moved, false if the system was not found.
+     */
+    template <typename T>
+    static bool move(std::size_t pos) {
+      const std::size_t type = type_id<sys::system>::get<T>();
+      auto it = std::find_if(_systems.begin(), _systems.end(),
+        [&type](const sys::system_uptr& s) { return s->type == type; });
+      if (it == _systems.end()) return false;
+      if (pos >= _systems.size()) pos = _systems.size() - 1;
+      const std::size_t from = std::distance(_systems.begin(), it);
+      if (from < pos) std::rotate(it, it + 1, _systems.begin() + pos + 1);
+      else std::rotate(_systems.begin() + pos, it, it + 1);
+      stages_dirty = true;
       return true;
     };
 };
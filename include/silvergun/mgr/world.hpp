@@ -15,15 +15,27 @@
 #include <unordered_map>
 #include <utility>
 #include <iterator>
+#include <cstddef>
 #include <algorithm>
 #include <limits>
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <tuple>
 #include <mutex>
+#include <atomic>
+#include <type_traits>
+#include <functional>
+#include <array>
 
 #include "silvergun/mgr/manager.hpp"
 
 #include "silvergun/_debug/exceptions.hpp"
 #include "silvergun/_globals/engine_time.hpp"
+#include "silvergun/_globals/job_pool.hpp"
+#include "silvergun/_globals/pool_allocator.hpp"
+#include "silvergun/_globals/snapshot.hpp"
+#include "silvergun/_globals/symbols.hpp"
 #include "silvergun/cmp/component.hpp"
 
 namespace slv {
@@ -31,10 +43,31 @@ namespace slv {
 
   /* Define containers for entity/component/world storage. */
   /*!
-  * \typedef std::size_t entity_id
+  * \typedef std::uint64_t entity_id
   * Container to store an entity id.
+  *
+  * The low 32 bits hold the entity's slot index and the high 32 bits its generation.
+  * The generation changes each time a slot is reused, so IDs of deleted entities stay invalid.
   */
-  using entity_id = std::size_t;
+  using entity_id = std::uint64_t;
+
+  /*!
+  * \brief Get the slot index part of an entity ID.
+  * \param e_id Entity ID.
+  * \return Slot index.
+  */
+  inline constexpr std::size_t entity_index(const entity_id& e_id) {
+    return static_cast<std::size_t>(e_id & 0xFFFFFFFF);
+  };
+
+  /*!
+  * \brief Get the generation part of an entity ID.
+  * \param e_id Entity ID.
+  * \return Generation of the slot when the ID was created.
+  */
+  inline constexpr std::size_t entity_generation(const entity_id& e_id) {
+    return static_cast<std::size_t>(e_id >> 32);
+  };
 
   /*!
   * \typedef std::pair<entity_id, std::string> entity
@@ -60,33 +93,390 @@ namespace slv {
   */
   using const_entity_container = std::vector<cmp::component_csptr>;
 
+  template <typename T>
+  class component_view;
+
+  template <typename... Ts>
+  class component_query;
+
+  class tag_view;
+  class prefab;
+
   /*!
-  * Container for storing components of similar type.
+  * Container for accessing components of similar type.
   * \tparam Component type
   */
   template <typename T>
-  using component_container = std::map<const entity_id, std::shared_ptr<T>>;
+  using component_container = component_view<T>;
 
   /*!
-  * Constant container for storing components of similar type.
+  * Constant container for accessing components of similar type.
   * \tparam Component type
   */
   template <typename T>
-  using const_component_container = std::map<const entity_id, std::shared_ptr<const T>>;
+  using const_component_container = component_view<const T>;
+
+  /*!
+  * \class component_storage
+  * \brief Interface for the per-type component pools used by the world.
+  */
+  class component_storage {
+    friend class mgr::world;
+
+    protected:
+      /*!
+       * \brief Create a component pool.
+       * \param t Type ID of the stored components.
+       * \param b Type ID of the base the components can be searched by.
+       */
+      component_storage(const cmp::component_id& t, const cmp::component_id& b) : type(t), base(b) {};
+
+      //  Version given to components changed now.  Shared by all pools and advanced by the world.
+      inline static std::atomic<std::uint64_t> change_tick = 1;
+
+    public:
+      virtual ~component_storage() = default;  //  Default virtual destructor.
+
+      const cmp::component_id type;  //!<  Type ID of the stored components.
+      const cmp::component_id base;  //!<  Type ID of the base the components can be searched by.
+
+      //!  Check if an entity has a component in this pool.
+      virtual bool contains(const entity_id& e_id) const = 0;
+      //!  Store a component for an entity.  Return false if it already has one.
+      virtual bool add(const entity_id& e_id, const cmp::component_sptr& c) = 0;
+      //!  Remove the component belonging to an entity.  Return false if none.
+      virtual bool remove(const entity_id& e_id) = 0;
+      //!  Get the component belonging to an entity, nullptr if none.
+      virtual cmp::component_sptr at(const entity_id& e_id) const = 0;
+      //!  Get the entity ID stored at a position in the pool.
+      virtual entity_id id_at(const std::size_t& pos) const = 0;
+      //!  Get the component stored at a position in the pool.
+      virtual cmp::component* ptr_at(const std::size_t& pos) const = 0;
+      //!  Mark the component belonging to an entity as changed.
+      virtual void touch(const entity_id& e_id) = 0;
+      //!  Get the version of the component belonging to an entity, 0 if none.
+      virtual std::uint64_t version(const entity_id& e_id) const = 0;
+      //!  Number of components stored.
+      virtual std::size_t size(void) const = 0;
+      //!  Remove all components.
+      virtual void clear(void) = 0;
+  };
+
+  /*!
+  * \class component_pool
+  * \brief Sparse set storing all components of a single type.
+  *
+  * Components are kept packed in insertion order with a sparse array
+  * indexed by entity slot for lookups.
+  * Removal swaps the last component into the freed position.
+  * Each component has a version recording when it was last changed.
+  *
+  * \tparam T Component type.
+  */
+  template <typename T>
+  class component_pool final : public component_storage {
+    private:
+      inline static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+      std::vector<std::size_t> sparse;       //  Entity slot index to packed position.
+      std::vector<entity_id> ids;            //  Packed entity IDs.
+      std::vector<std::shared_ptr<T>> data;  //  Packed components.
+      std::vector<std::uint64_t> versions;   //  Packed component versions.
+
+      //  Get the packed position for an entity, npos if not stored.
+      std::size_t position(const entity_id& e_id) const {
+        const std::size_t idx = entity_index(e_id);
+        if (idx >= sparse.size() || sparse[idx] == npos) return npos;
+        //  Make sure the slot was not reused by a newer entity.
+        if (ids[sparse[idx]] != e_id) return npos;
+        return sparse[idx];
+      };
+
+    public:
+      component_pool() :
+        component_storage(cmp::get_type_id<T>(), cmp::get_type_id<typename T::base_type>()) {};
+      ~component_pool() = default;  //  Default destructor.
+
+      /*!
+       * \brief Insert a component for an entity.
+       * \param e_id Entity ID.
+       * \param c Component to store.
+       * \return False if the entity already has a component in this pool.
+       */
+      bool insert(const entity_id& e_id, std::shared_ptr<T> c) {
+        const std::size_t idx = entity_index(e_id);
+        if (idx >= sparse.size()) sparse.resize(idx + 1, npos);
+        else if (sparse[idx] != npos) return false;
+        sparse[idx] = ids.size();
+        ids.push_back(e_id);
+        data.push_back(std::move(c));
+        versions.push_back(change_tick);
+        return true;
+      };
+
+      /*!
+       * \brief Insert components for a number of entities in one pass.
+       *
+       * Entities that already have a component in this pool are skipped.
+       *
+       * \param e_ids Entity IDs.
+       * \param slot_count Number of entity slots, entities past it are skipped.
+       * \param make Function to create the component for an entity, skipped if it returns nullptr.
+       * \return Number of components inserted.
+       */
+      template <typename F>
+      std::size_t insert_many(const std::vector<entity_id>& e_ids, const std::size_t& slot_count, const F& make) {
+        reserve(e_ids.size(), slot_count);
+
+        const std::size_t start = ids.size();
+        for (auto& it: e_ids) {
+          const std::size_t idx = entity_index(it);
+          if (idx >= slot_count || sparse[idx] != npos) continue;
+          std::shared_ptr<T> c = make(it);
+          if (c == nullptr) continue;
+          sparse[idx] = ids.size();
+          ids.push_back(it);
+          data.push_back(std::move(c));
+          versions.push_back(change_tick);
+        }
+        return ids.size() - start;
+      };
+
+      /*!
+       * \brief Make room for more components.
+       * \param n Number of components to make room for.
+       * \param slot_count Number of entity slots to make room for.
+       */
+      void reserve(const std::size_t& n, const std::size_t& slot_count) {
+        ids.reserve(ids.size() + n);
+        data.reserve(data.size() + n);
+        versions.reserve(versions.size() + n);
+        if (slot_count > sparse.size()) sparse.resize(slot_count, npos);
+      };
+
+      /*!
+       * \brief Find the component for an entity.
+       * \param e_id Entity ID.
+       * \return The component, nullptr if not found.
+       */
+      const std::shared_ptr<T> find(const entity_id& e_id) const {
+        const std::size_t pos = position(e_id);
+        if (pos == npos) return nullptr;
+        return data[pos];
+      };
+
+      /*!
+       * \brief Get a pointer to the component for an entity.
+       * \param e_id Entity ID.
+       * \return Pointer to the component, nullptr if not found.
+       */
+      T* get(const entity_id& e_id) const {
+        const std::size_t pos = position(e_id);
+        if (pos == npos) return nullptr;
+        return data[pos].get();
+      };
+
+      bool contains(const entity_id& e_id) const override {
+        return (position(e_id) != npos);
+      };
+
+      bool add(const entity_id& e_id, const cmp::component_sptr& c) override {
+        return insert(e_id, std::static_pointer_cast<T>(c));
+      };
+
+      bool remove(const entity_id& e_id) override {
+        const std::size_t pos = position(e_id);
+        if (pos == npos) return false;
+
+        //  Move the last component into the freed position.
+        sparse[entity_index(e_id)] = npos;
+        if (pos != ids.size() - 1) {
+          ids[pos] = ids.back();
+          data[pos] = std::move(data.back());
+          versions[pos] = versions.back();
+          sparse[entity_index(ids[pos])] = pos;
+        }
+        ids.pop_back();
+        data.pop_back();
+        versions.pop_back();
+        return true;
+      };
+
+      cmp::component_sptr at(const entity_id& e_id) const override { return find(e_id); };
+      entity_id id_at(const std::size_t& pos) const override { return ids[pos]; };
+      cmp::component* ptr_at(const std::size_t& pos) const override { return data[pos].get(); };
+      std::size_t size(void) const override { return ids.size(); };
+
+      void touch(const entity_id& e_id) override {
+        const std::size_t pos = position(e_id);
+        if (pos != npos) versions[pos] = change_tick;
+      };
+
+      std::uint64_t version(const entity_id& e_id) const override {
+        const std::size_t pos = position(e_id);
+        if (pos == npos) return 0;
+        return versions[pos];
+      };
+
+      void clear(void) override {
+        sparse.clear();
+        ids.clear();
+        data.clear();
+        versions.clear();
+      };
+  };
+
+  /*!
+  * \class tag_set
+  * \brief Sparse set of the entities that have a tag.
+  *
+  * Tags store no data, only which entities have them.
+  */
+  class tag_set final {
+    private:
+      inline static const std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+      std::vector<std::size_t> sparse;  //  Entity slot index to packed position.
+      std::vector<entity_id> ids;       //  Packed entity IDs.
+
+    public:
+      tag_set() = default;   //  Default constructor.
+      ~tag_set() = default;  //  Default destructor.
+
+      /*!
+       * \brief Check if an entity has the tag.
+       * \param e_id Entity ID.
+       * \return True if the entity has the tag.
+       */
+      bool contains(const entity_id& e_id) const {
+        const std::size_t idx = entity_index(e_id);
+        if (idx >= sparse.size() || sparse[idx] == npos) return false;
+        return (ids[sparse[idx]] == e_id);
+      };
+
+      /*!
+       * \brief Give an entity the tag.
+       * \param e_id Entity ID.
+       * \return False if the entity already has the tag.
+       */
+      bool insert(const entity_id& e_id) {
+        const std::size_t idx = entity_index(e_id);
+        if (idx >= sparse.size()) sparse.resize(idx + 1, npos);
+        else if (sparse[idx] != npos) return false;
+        sparse[idx] = ids.size();
+        ids.push_back(e_id);
+        return true;
+      };
+
+      /*!
+       * \brief Remove the tag from an entity.
+       * \param e_id Entity ID.
+       * \return False if the entity does not have the tag.
+       */
+      bool remove(const entity_id& e_id) {
+        if (!contains(e_id)) return false;
+        const std::size_t idx = entity_index(e_id);
+        const std::size_t pos = sparse[idx];
+
+        //  Move the last entity into the freed position.
+        sparse[idx] = npos;
+        if (pos != ids.size() - 1) {
+          ids[pos] = ids.back();
+          sparse[entity_index(ids[pos])] = pos;
+        }
+        ids.pop_back();
+        return true;
+      };
+
+      /*!
+       * \brief Get the entities with the tag.
+       * \return The packed entity IDs.
+       */
+      const std::vector<entity_id>& entities(void) const { return ids; };
+
+      /*!
+       * \brief Remove the tag from all entities.
+       */
+      void clear(void) {
+        sparse.clear();
+        ids.clear();
+      };
+  };
 
   /*!
-  * \typedef std::unordered_multimap<entity_id, cmp::component_sptr> world_map
-  * Container to store the entire game world.
+  * \class storage_list
+  * \brief List of the component pools or tag sets in use.
+  *
+  * A type can be used for the first time inside a parallel system stage,
+  * so entries are added under a lock and never moved.
+  * Other threads can read the list while it is added to.
+  *
+  * \tparam T Storage type.
   */
-  using world_map = std::unordered_multimap<entity_id, cmp::component_sptr>;
+  template <typename T>
+  class storage_list final {
+    private:
+      inline static const std::size_t BLOCK_SIZE = 64;   //  Entries per block.
+      inline static const std::size_t BLOCK_COUNT = 64;  //  Most blocks in the list.
+
+      std::array<std::unique_ptr<T*[]>, BLOCK_COUNT> blocks;  //  Entries, in blocks that are never moved.
+      std::atomic<std::size_t> count = 0;                    //  Number of entries, set once each is written.
+      std::mutex mtx;                                        //  Lock for adding entries.
+
+    public:
+      storage_list() = default;   //  Default constructor.
+      ~storage_list() = default;  //  Default destructor.
+
+      //  Iterator over the entries added when it was created.
+      class iterator {
+        public:
+          iterator(const storage_list* l, const std::size_t& p) : list(l), pos(p) {};
+          T*& operator*() const { return list->blocks[pos / BLOCK_SIZE][pos % BLOCK_SIZE]; };
+          iterator& operator++() { pos++; return *this; };
+          bool operator!=(const iterator& other) const { return pos != other.pos; };
+
+        private:
+          const storage_list* list;
+          std::size_t pos;
+      };
+
+      /*!
+       * \brief Add an entry.
+       * \param item Entry to add.
+       * \exception engine_exception The list is full.
+       */
+      void push_back(T* item) {
+        std::lock_guard<std::mutex> lock(mtx);
+        const std::size_t pos = count.load(std::memory_order_relaxed);
+        if (pos >= BLOCK_SIZE * BLOCK_COUNT) throw engine_exception("Too many component or tag types", "World", 1);
+        if (pos % BLOCK_SIZE == 0) blocks[pos / BLOCK_SIZE] = std::make_unique<T*[]>(BLOCK_SIZE);
+        blocks[pos / BLOCK_SIZE][pos % BLOCK_SIZE] = item;
+        count.store(pos + 1, std::memory_order_release);
+      };
+
+      /*!
+       * \brief Get the number of entries.
+       * \return Number of entries.
+       */
+      std::size_t size(void) const { return count.load(std::memory_order_acquire); };
+
+      /*!
+       * \brief Get an entry by position.
+       * \param pos Position, less than size.
+       * \return The entry.
+       */
+      T* operator[](const std::size_t& pos) const { return blocks[pos / BLOCK_SIZE][pos % BLOCK_SIZE]; };
+
+      iterator begin(void) const { return iterator(this, 0); };       //!<  Iterator to the first entry.
+      iterator end(void) const { return iterator(this, size()); };   //!<  Iterator past the last entry.
+  };
 }
 
 namespace slv::mgr {
 
-inline static const entity_id ENTITY_ERROR = 0;  //!<  Entity error code.
-inline static const entity_id ENTITY_START = 1;  //!<  Start of Entity counter.
-inline static const entity_id ENTITY_MAX =       //!<  Entity max value.
-  std::numeric_limits<entity_id>::max();
+inline static const entity_id ENTITY_ERROR = 0;           //!<  Entity error code.
+inline static const std::size_t ENTITY_START = 1;         //!<  First entity slot index.
+inline static const std::size_t ENTITY_MAX = 0xFFFFFFFF;  //!<  Entity slot index and generation max value.
 
 /*!
  * \class world
@@ -94,6 +484,13 @@ inline static const entity_id ENTITY_MAX =       //!<  Entity max value.
  */
 class world final : private manager<world> {
   friend class slv::engine;
+  template <typename T>
+  friend class slv::component_view;
+  template <typename... Ts>
+  friend class slv::component_query;
+  friend class slv::tag_view;
+  friend class slv::prefab;
+  friend class spawner;
 
   private:
     world() = default;
@@ -101,75 +498,726 @@ class world final : private manager<world> {
 
     //  Clear the entity manager.
     static void clear(void) {
-      entity_counter = ENTITY_START;
-      entity_vec.clear();     //  Clear entities vector
-      _world.clear();         //  Clear the world block
+      slots.clear();          //  Clear entity slots
+      free_slots.clear();
+      name_index.clear();     //  Clear the name lookup index
+      pending_entities.clear();
+      pending_components.clear();
+      pending_index.clear();
+      pending_adds = 0;
+      pending_tags.clear();
+      pending_activations.clear();
+      stashes.clear();        //  Clear deactivated entities
+      restore_pending = false;
+      pending_restore.clear();
+      entity_count = 0;
+      for (auto& it: _pools) it->clear();  //  Clear the component pools
+      for (auto& it: _tag_sets) it->clear();  //  Clear the tags
+      memory_pools::release();             //  Free component memory no longer in use
+    };
+
+    //  Get the pool for a component type, registering it on first use.
+    template <typename T>
+    inline static component_pool<T>& pool(void) {
+      static_assert(std::is_base_of_v<cmp::component, T>, "Type must be a component!");
+      //  Register the pool the first time the type is used.
+      static const bool registered = [](){ _pools.push_back(&_components<T>); return true; }();
+      (void)registered;
+      return _components<T>;
+    };
+
+    //  Get the set for a tag type, registering it on first use.
+    template <typename T>
+    inline static tag_set& tags(void) {
+      static_assert(std::is_empty_v<T>, "Tag must be an empty type!");
+      //  Register the set the first time the tag is used.
+      static const bool registered = [](){ _tag_sets.push_back(&_tags<T>); return true; }();
+      (void)registered;
+      return _tags<T>;
+    };
+
+    //  Find a component by type for an entity.  Returns nullptr if not found.
+    //  Final types are looked up directly in their pool, others by searching all pools.
+    template <typename T>
+    inline static const std::shared_ptr<T> find(const entity_id& e_id) {
+      if constexpr (std::is_final_v<T>) {
+        std::shared_ptr<T> c = pool<T>().find(e_id);
+        return (c ? c : std::static_pointer_cast<T>(find_pending<T>(e_id).c));
+      } else {
+        check_lookup<T>();
+        for (auto& it: _pools) {
+          if (!holds<T>(it)) continue;
+          const cmp::component_sptr c = it->at(e_id);
+          if (c) return std::static_pointer_cast<T>(c);
+        }
+        return std::static_pointer_cast<T>(find_pending<T>(e_id).c);
+      }
+    };
+
+    //  Find the pool storing a component by type for an entity.  Returns nullptr if not found.
+    template <typename T>
+    inline static component_storage* find_pool(const entity_id& e_id) {
+      if constexpr (std::is_final_v<T>) return (pool<T>().contains(e_id) ? &_components<T> : nullptr);
+      else {
+        check_lookup<T>();
+        for (auto& it: _pools) {
+          if (holds<T>(it) && it->contains(e_id)) return it;
+        }
+        return nullptr;
+      }
+    };
+
+    //  Log once in debug mode when a type that is not final is searched for with no types registered under it.
+    //  Only the type itself and types naming it as their base_type are found, deeper derived types are not.
+    //  If nothing derives from the type, it should be final so it is looked up directly.
+    template <typename T>
+    inline static void check_lookup(void) {
+      if constexpr (build_options.debug_mode && !std::is_same_v<T, cmp::component>) {
+        static std::once_flag checked;
+        std::call_once(checked, []() {
+          for (auto& it: _pools)
+            if (it->base == cmp::get_type_id<T>() && it->type != cmp::get_type_id<T>()) return;
+          logger::log("Component type searched for is not final and has no derived types registered",
+            "World", 1, engine_time::check());
+        });
+      }
     };
 
-    inline static entity_id entity_counter = ENTITY_START;  //  Last Entity ID used.
-    inline static entities entity_vec;  //  Container for all entities.
-    inline static world_map _world;     //  Container for all components.
+    //  Check if a pool holds components of a type, either directly or by their base type.
+    template <typename T>
+    inline static bool holds(const component_storage* p) {
+      if constexpr (std::is_final_v<T>) return (p == &_components<T>);
+      else if constexpr (std::is_same_v<T, cmp::component>) return true;
+      else return (p->type == cmp::get_type_id<T>() || p->base == cmp::get_type_id<T>());
+    };
+
+    //  Start recording structural changes instead of applying them.
+    //  Used by views while iterating and by the engine while systems run.
+    static void lock(void) { lock_count++; };
+
+    //  Release a lock.  Apply recorded changes once the world is no longer locked.
+    static void unlock(void) {
+      if (--lock_count > 0) return;
+      flush();
+    };
+
+    //  Apply all recorded structural changes in one pass.
+    static void flush(void) {
+      //  A restore replaces the whole world, other changes are dropped.
+      if (restore_pending) {
+        restore_pending = false;
+        pending_components.clear();
+        pending_index.clear();
+        pending_adds = 0;
+        pending_tags.clear();
+        pending_activations.clear();
+        pending_entities.clear();
+        snapshot temp_snapshot = std::move(pending_restore);
+        pending_restore.clear();
+        //  The snapshot was checked when the restore was requested.
+        //  If a component still fails to load, the world is left as it was.
+        //  Nothing can be thrown from here, as views unlock the world in their destructors.
+        try {
+          load_snapshot(temp_snapshot);
+        } catch (...) {
+          if constexpr (build_options.debug_mode)
+            logger::log("Deferred snapshot restore failed", "World", 2, engine_time::check());
+        }
+        return;
+      }
+
+      auto temp_components = std::move(pending_components);
+      auto temp_tags = std::move(pending_tags);
+      auto temp_activations = std::move(pending_activations);
+      auto temp_entities = std::move(pending_entities);
+      pending_components.clear();
+      pending_index.clear();
+      pending_adds = 0;
+      pending_tags.clear();
+      pending_activations.clear();
+      pending_entities.clear();
+
+      //  Group component changes by pool, keeping their recorded order within each pool.
+      std::stable_sort(temp_components.begin(), temp_components.end(),
+        [](const component_command& a, const component_command& b) {
+          return std::less<component_storage*>()(a.pool, b.pool);
+        });
+      for (auto& it: temp_components) {
+        if (it.c == nullptr) it.pool->remove(it.e_id);
+        else if (entity_exists(it.e_id)) it.pool->add(it.e_id, it.c);
+      }
+      for (auto& it: temp_tags) {
+        if (!it.add) it.tags->remove(it.e_id);
+        else if (entity_exists(it.e_id)) it.tags->insert(it.e_id);
+      }
+      for (auto& it: temp_activations) {
+        if (it.second) activate(it.first);
+        else deactivate(it.first);
+      }
+
+      //  Delete entities last, in slot order, removing their components one pool at a time.
+      std::sort(temp_entities.begin(), temp_entities.end(),
+        [](const entity_id& a, const entity_id& b) { return entity_index(a) < entity_index(b); });
+      temp_entities.erase(std::unique(temp_entities.begin(), temp_entities.end()), temp_entities.end());
+      for (auto& p: _pools) {
+        for (auto& it: temp_entities) p->remove(it);
+      }
+      for (auto& t: _tag_sets) {
+        for (auto& it: temp_entities) t->remove(it);
+      }
+      for (auto& it: temp_entities) {
+        entity_slot* slot = get_slot(it);
+        if (slot != nullptr) release_slot(*slot);
+      }
+    };
+
+    //  A recorded change to a component pool.
+    struct component_command {
+      component_storage* pool;  //  Pool to change.
+      entity_id e_id;           //  Entity to change.
+      cmp::component_sptr c;    //  Component to add, nullptr to remove.
+    };
+
+    inline static std::atomic<std::size_t> lock_count = 0;  //  Number of active locks.
+    inline static std::mutex command_mtx;  //  Lock for recording changes from multiple threads.
+    inline static std::vector<entity_id> pending_entities;  //  Entities to delete on unlock.
+    inline static std::vector<component_command> pending_components;  //  Component changes to apply on unlock.
+    inline static std::atomic<std::size_t> pending_adds = 0;          //  Number of components recorded to be added.
+    //  Positions in pending_components of the adds, and deletes of those adds, by entity.
+    inline static std::unordered_map<entity_id, std::vector<std::size_t>> pending_index;
+
+    //  Record a component change while the world is locked.  Must hold command_mtx.
+    //  Adds, and deletes of components not yet added, are indexed so they can be found.
+    static void push_pending(component_command&& cmd, const bool& indexed) {
+      if (indexed) pending_index[cmd.e_id].push_back(pending_components.size());
+      if (cmd.c != nullptr) pending_adds++;
+      pending_components.push_back(std::move(cmd));
+    };
+
+    //  Find a component recorded to be added while the world is locked.  Must hold command_mtx.
+    //  The returned command has no component if there is none, or if it was recorded to be deleted after.
+    template <typename T>
+    inline static component_command find_pending_locked(const entity_id& e_id) {
+      auto it = pending_index.find(e_id);
+      if (it != pending_index.end()) {
+        for (auto pos = it->second.rbegin(); pos != it->second.rend(); pos++) {
+          if (holds<T>(pending_components[*pos].pool)) return pending_components[*pos];
+        }
+      }
+      return { nullptr, e_id, nullptr };
+    };
+
+    //  Find a component recorded to be added while the world is locked.
+    template <typename T>
+    inline static component_command find_pending(const entity_id& e_id) {
+      if (pending_adds == 0) return { nullptr, e_id, nullptr };
+      std::lock_guard<std::mutex> lock(command_mtx);
+      return find_pending_locked<T>(e_id);
+    };
+
+    //  A recorded change to a tag set.
+    struct tag_command {
+      tag_set* tags;   //  Tag set to change.
+      entity_id e_id;  //  Entity to change.
+      bool add;        //  True to add the tag, false to remove it.
+    };
+
+    inline static std::vector<tag_command> pending_tags;  //  Tag changes to apply on unlock.
+    inline static std::vector<std::pair<entity_id, bool>> pending_activations;  //  Entities to activate (true) or deactivate on unlock.
+
+    //  Components and tags of a deactivated entity, kept out of the world until it is activated.
+    struct entity_stash {
+      std::vector<std::pair<component_storage*, cmp::component_sptr>> components;  //  Components with their pools.
+      std::vector<tag_set*> tags;  //  Tags the entity had.
+    };
+
+    inline static std::unordered_map<entity_id, entity_stash> stashes;  //  Deactivated entities.
+
+    //  Check if an entity will be active once pending activations are applied.
+    static bool will_be_active(const entity_id& e_id) {
+      for (auto it = pending_activations.rbegin(); it != pending_activations.rend(); it++)
+        if (it->first == e_id) return it->second;
+      return stashes.find(e_id) == stashes.end();
+    };
+
+    //  Move an entity's components and tags out of the world.
+    static void stash(const entity_id& e_id) {
+      entity_stash& st = stashes[e_id];
+      for (auto& it: _pools) {
+        cmp::component_sptr c = it->at(e_id);
+        if (c == nullptr) continue;
+        st.components.push_back(std::make_pair(it, std::move(c)));
+        it->remove(e_id);
+      }
+      for (auto& it: _tag_sets) {
+        if (it->remove(e_id)) st.tags.push_back(it);
+      }
+    };
+
+    //  Move an entity's components and tags back into the world.
+    static void unstash(const entity_id& e_id) {
+      auto s_it = stashes.find(e_id);
+      if (s_it == stashes.end()) return;
+      for (auto& it: s_it->second.components) it.first->add(e_id, it.second);
+      for (auto& it: s_it->second.tags) it->insert(e_id);
+      stashes.erase(s_it);
+    };
+
+    //  Construct a new component in place of a deactivated entity's component of the same type.
+    //  Keeps the component's memory when the constructor cannot throw.
+    //  Otherwise the new component is built first, so a throwing constructor leaves the old one as it was.
+    //  Returns false if the entity has no such component stashed.
+    template <typename T, typename... Args>
+    inline static bool reconstruct(const entity_id& e_id, Args... args) {
+      auto s_it = stashes.find(e_id);
+      if (s_it == stashes.end()) return false;
+      for (auto& it: s_it->second.components) {
+        if (it.first != &_components<T>) continue;
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+          T* c = static_cast<T*>(it.second.get());
+          c->~T();
+          ::new (static_cast<void*>(c)) T(args...);
+          c->type = cmp::get_type_id<T>();
+        } else {
+          std::shared_ptr<T> c = std::allocate_shared<T>(pool_allocator<T>(), args...);
+          c->type = cmp::get_type_id<T>();
+          it.second = std::move(c);
+        }
+        return true;
+      }
+      return false;
+    };
+
+    //  Drop a deactivated entity's components and tags, except those kept in the given storage.
+    static void trim_stash(const entity_id& e_id, const std::vector<const void*>& keep) {
+      auto s_it = stashes.find(e_id);
+      if (s_it == stashes.end()) return;
+      const auto kept = [&keep](const void* store) {
+        return std::find(keep.begin(), keep.end(), store) != keep.end();
+      };
+      auto& components = s_it->second.components;
+      components.erase(std::remove_if(components.begin(), components.end(),
+        [&kept](const auto& it) { return !kept(it.first); }), components.end());
+      auto& tag_list = s_it->second.tags;
+      tag_list.erase(std::remove_if(tag_list.begin(), tag_list.end(),
+        [&kept](const tag_set* it) { return !kept(it); }), tag_list.end());
+    };
+
+    inline static bool restore_pending = false;  //  If a snapshot is waiting to be restored on unlock.
+    inline static snapshot pending_restore;      //  Snapshot to restore on unlock.
+
+    //  Snapshot functions for a component or tag type.
+    struct serializer {
+      std::function<void(snapshot&)> save;                     //  Write the count, then each entity ID and component.
+      std::function<void(const entity_id&, snapshot&)> load;  //  Read and add a component.
+      std::function<void(const std::size_t&)> reserve;        //  Make room for components.
+    };
+
+    inline static std::map<std::string, serializer> serializers;  //  Snapshot functions by key.
+    inline static const std::uint32_t SNAPSHOT_MAGIC = 0x534C5653;  //  Snapshot file identifier.
+    inline static const std::uint32_t SNAPSHOT_VERSION = 2;         //  Snapshot format version.
+    inline static std::size_t restore_count = 0;                     //  Number of snapshots restored.
+    inline static bool restore_failed = false;                       //  If the last snapshot failed to load.
+
+    //  Check a snapshot's header, that each of its sections fits in the data,
+    //  and that the entity slots and free slots agree with each other.
+    static void check_snapshot(snapshot& snap) {
+      snap.rewind();
+      if (snap.read<std::uint32_t>() != SNAPSHOT_MAGIC || snap.read<std::uint32_t>() != SNAPSHOT_VERSION)
+        throw engine_exception("Bad snapshot format", "World", 2);
+
+      //  State of each slot:  zero free, one active, two deactivated, three listed as free.
+      std::vector<std::uint8_t> states;
+      const std::uint64_t slot_count = snap.read<std::uint64_t>();
+      if (slot_count > ENTITY_MAX) throw engine_exception("Bad snapshot entity count", "World", 2);
+      for (std::uint64_t i = 0; i < slot_count; i++) {
+        const entity_id e_id = snap.read<entity_id>();
+        const std::uint8_t state = snap.read<std::uint8_t>();
+        if (entity_index(e_id) != i || state > 2 || (i < ENTITY_START && state != 0))
+          throw engine_exception("Bad snapshot entity slot", "World", 2);
+        if (state != 0) snap.read_string();
+        states.push_back(state);
+      }
+      const std::uint64_t free_count = snap.read<std::uint64_t>();
+      for (std::uint64_t i = 0; i < free_count; i++) {
+        const std::uint64_t idx = snap.read<std::uint64_t>();
+        if (idx < ENTITY_START || idx >= slot_count || states[idx] != 0)
+          throw engine_exception("Bad snapshot free slot", "World", 2);
+        states[idx] = 3;
+      }
+
+      const std::uint32_t type_count = snap.read<std::uint32_t>();
+      for (std::uint32_t i = 0; i < type_count; i++) {
+        snap.read_string();
+        snap.skip(snap.read<std::uint64_t>());
+      }
+    };
+
+    //  Rebuild the world from a snapshot.
+    //  The snapshot is checked first.  If it fails to load, the world is put back as it was.
+    static void load_snapshot(snapshot& snap) {
+      check_snapshot(snap);
+
+      world_backup backup = take_backup();
+      try {
+        read_snapshot(snap);
+      } catch (...) {
+        clear();
+        put_back(backup);
+        restore_failed = true;
+        throw;
+      }
+      restore_failed = false;
+      restore_count++;
+    };
+
+    //  Read the entities and components from a checked snapshot into an empty world.
+    static void read_snapshot(snapshot& snap) {
+      snap.rewind();
+      snap.skip(2 * sizeof(std::uint32_t));  //  Header.
+
+      //  Entity slots.
+      std::vector<entity_id> inactive;
+      slots.resize(snap.read<std::uint64_t>());
+      for (std::size_t idx = 0; idx < slots.size(); idx++) {
+        entity_slot& slot = slots[idx];
+        slot.id = snap.read<entity_id>();
+        const std::uint8_t state = snap.read<std::uint8_t>();
+        slot.alive = (state != 0);
+        if (state == 2) inactive.push_back(slot.id);
+        slot.name = 0;
+        if (slot.alive) {
+          //  Only names that were set are stored, default names are left empty.
+          const std::string name = snap.read_string();
+          if (!name.empty() && name != default_name(idx)) {
+            slot.name = symbols::intern(name);
+            name_index.insert(std::make_pair(slot.name, slot.id));
+          }
+          entity_count++;
+        }
+      }
+      free_slots.resize(snap.read<std::uint64_t>());
+      for (auto& it: free_slots) it = snap.read<std::uint64_t>();
+
+      //  Components, skipping types with no serializer.
+      const std::uint32_t type_count = snap.read<std::uint32_t>();
+      for (std::uint32_t i = 0; i < type_count; i++) {
+        const std::string key = snap.read_string();
+        const std::uint64_t block_size = snap.read<std::uint64_t>();
+        const auto s_it = serializers.find(key);
+        if (s_it == serializers.end()) {
+          snap.skip(block_size);
+          continue;
+        }
+        const std::uint64_t count = snap.read<std::uint64_t>();
+        s_it->second.reserve(count);
+        for (std::uint64_t j = 0; j < count; j++) {
+          const entity_id e_id = snap.read<entity_id>();
+          s_it->second.load(e_id, snap);
+        }
+      }
+
+      //  Deactivate entities that were saved deactivated, once they have their components.
+      for (auto& it: inactive) stash(it);
+    };
+
+    //  Storage for a single entity.
+    struct entity_slot {
+      entity_id id;  //  Current ID for the slot, including generation.
+      bool alive;    //  If the slot holds a living entity.
+      symbol name;   //  Entity name, 0 for the slot's default name.
+    };
+
+    //  Default name of entities in a slot.  Made when asked for, so it is not interned for every entity.
+    static std::string default_name(const std::size_t& idx) {
+      return "Entity" + std::to_string(idx);
+    };
+
+    //  Get the slot index of the living entity using a default name, 0 if there is none.
+    static std::size_t default_name_index(const std::string& name) {
+      static const std::string prefix = "Entity";
+      if (name.size() <= prefix.size() || name.size() > prefix.size() + 10) return 0;
+      if (name.compare(0, prefix.size(), prefix) != 0 || name[prefix.size()] == '0') return 0;
+      std::size_t idx = 0;
+      for (std::size_t i = prefix.size(); i < name.size(); i++) {
+        if (name[i] < '0' || name[i] > '9') return 0;
+        idx = idx * 10 + static_cast<std::size_t>(name[i] - '0');
+      }
+      if (idx < ENTITY_START || idx >= slots.size()) return 0;
+      if (!slots[idx].alive || slots[idx].name != 0) return 0;
+      return idx;
+    };
+
+    //  Get the name of a slot's entity.
+    static std::string slot_name(const entity_slot& slot) {
+      if (slot.name == 0) return default_name(entity_index(slot.id));
+      return symbols::str(slot.name);
+    };
+
+    //  Get the slot for a living entity, nullptr if the ID is not valid.
+    static entity_slot* get_slot(const entity_id& e_id) {
+      const std::size_t idx = entity_index(e_id);
+      if (idx < ENTITY_START || idx >= slots.size()) return nullptr;
+      entity_slot& slot = slots[idx];
+      if (!slot.alive || slot.id != e_id) return nullptr;
+      return &slot;
+    };
+
+    //  Free the slot of a deleted entity.  Advance its generation so the old ID stays invalid.
+    static void release_slot(entity_slot& slot) {
+      stashes.erase(slot.id);  //  Drop components kept while deactivated.
+      if (slot.name != 0) name_index.erase(slot.name);
+      slot.name = 0;
+      slot.alive = false;
+      entity_count--;
+      const std::size_t generation = entity_generation(slot.id) + 1;
+      //  Retire the slot once its generations run out.
+      if (generation > ENTITY_MAX) return;
+      const std::size_t idx = entity_index(slot.id);
+      slot.id = (static_cast<entity_id>(generation) << 32) | idx;
+      free_slots.push_back(idx);
+    };
+
+    inline static std::vector<entity_slot> slots;       //  Entity slots, indexed by entity index.
+    inline static std::vector<std::size_t> free_slots;  //  Indexes of deleted entity slots to reuse.
+    inline static std::size_t entity_count = 0;         //  Number of living entities.
+    inline static std::unordered_map<symbol, entity_id> name_index;  //  Entity name to entity ID.
+
+    template <typename T>
+    inline static component_pool<T> _components;           //  Component storage by type.
+    inline static storage_list<component_storage> _pools;  //  All component pools in use.
+
+    template <typename T>
+    inline static tag_set _tags;                     //  Tag storage by type.
+    inline static storage_list<tag_set> _tag_sets;   //  All tag sets in use.
+
+    //  Everything in the world, kept while a snapshot loads.
+    struct world_backup {
+      std::vector<entity_slot> slots;
+      std::vector<std::size_t> free_slots;
+      std::size_t entity_count;
+      std::unordered_map<symbol, entity_id> name_index;
+      std::unordered_map<entity_id, entity_stash> stashes;
+      std::vector<std::pair<component_storage*, std::vector<std::pair<entity_id, cmp::component_sptr>>>> components;
+      std::vector<std::pair<tag_set*, std::vector<entity_id>>> tags;
+    };
+
+    //  Move everything out of the world, leaving it empty.
+    static world_backup take_backup(void) {
+      world_backup backup;
+      backup.slots = std::move(slots);
+      backup.free_slots = std::move(free_slots);
+      backup.entity_count = entity_count;
+      backup.name_index = std::move(name_index);
+      backup.stashes = std::move(stashes);
+      for (auto& p: _pools) {
+        backup.components.emplace_back(p, std::vector<std::pair<entity_id, cmp::component_sptr>>());
+        backup.components.back().second.reserve(p->size());
+        for (std::size_t pos = 0; pos < p->size(); pos++)
+          backup.components.back().second.emplace_back(p->id_at(pos), p->at(p->id_at(pos)));
+      }
+      for (auto& t: _tag_sets) backup.tags.emplace_back(t, t->entities());
+      clear();
+      return backup;
+    };
+
+    //  Move a backup into an empty world.
+    static void put_back(world_backup& backup) {
+      slots = std::move(backup.slots);
+      free_slots = std::move(backup.free_slots);
+      entity_count = backup.entity_count;
+      name_index = std::move(backup.name_index);
+      stashes = std::move(backup.stashes);
+      for (auto& p: backup.components) {
+        for (auto& it: p.second) p.first->add(it.first, it.second);
+      }
+      for (auto& t: backup.tags) {
+        for (auto& it: t.second) t.first->insert(it);
+      }
+    };
 
   public:
     /*!
-     * \brief Create a new entity by name, using the next available ID.
-     * \return The newly created entity ID.  slv_ENTITY_ERROR on fail.
+     * \brief Create a new entity, reusing a deleted entity slot when available.
+     *
+     * Always takes effect immediately, so the ID can be given components right away.
+     *
+     * \return The newly created entity ID.  ENTITY_ERROR on fail.
      */
     static entity_id new_entity(void) {
-      entity_id next_id;
-
-      if (entity_counter == ENTITY_MAX) {  //  Counter hit max.
-        bool test = false;
-        //  Look for the first available ID.
-        for (next_id = ENTITY_START; !test; next_id++) {
-          if (next_id == ENTITY_MAX) return ENTITY_ERROR;  //  No available ID, error.
-          //  See if the new ID does not exist.
-          test = (std::find_if (entity_vec.begin(), entity_vec.end(), [&next_id](const entity& e){ return e.first == next_id; }) == entity_vec.end());
-        }
-      } else {  //  Counter not max, use the counter for entity ID.
-        next_id = entity_counter;
-        entity_counter++;
+      std::size_t idx;
+
+      if (!free_slots.empty()) {  //  Reuse a deleted slot.
+        idx = free_slots.back();
+        free_slots.pop_back();
+      } else {  //  No free slots, create a new one.
+        if (slots.empty()) slots.resize(ENTITY_START);  //  Reserve the slots used for error IDs.
+        if (slots.size() > ENTITY_MAX) return ENTITY_ERROR;  //  No available ID, error.
+        idx = slots.size();
+        slots.push_back({ static_cast<entity_id>(idx), false, 0 });
       }
+      entity_slot& slot = slots[idx];
 
-      //  Set a new name.  Make sure name doesn't exist.
-      std::string entity_name = "Entity" + std::to_string(next_id);
-      bool test = false;
-      for (entity_id temp_id = ENTITY_START; !test; temp_id++) {
-        if (temp_id == ENTITY_MAX) return ENTITY_ERROR;  //  Couldn't name entity, error.
-        //  See if the new name does not exist.
-        test = (std::find_if (entity_vec.begin(), entity_vec.end(), [&entity_name](const entity& e){ return e.second == entity_name; }) == entity_vec.end());
-        //  If it does, append the temp number and try that.
-        if (!test) entity_name = "Entity" + std::to_string(next_id) + std::to_string(temp_id);
+      //  Use the slot's default name.  Make sure another entity wasn't given it.
+      symbol entity_name = 0;
+      symbol taken = 0;
+      if (symbols::find(default_name(idx), taken) && name_index.find(taken) != name_index.end()) {
+        //  If it was, append the temp number and try that.
+        entity_name = taken;
+        for (std::size_t temp_id = ENTITY_START; name_index.find(entity_name) != name_index.end(); temp_id++)
+          entity_name = symbols::intern(default_name(idx) + std::to_string(temp_id));
+        name_index.insert(std::make_pair(entity_name, slot.id));
       }
 
       //  Tests complete, insert new entity.
-      entity_vec.push_back(std::make_pair(next_id, entity_name));
-      return next_id;  //  Return new entity ID.
+      slot.alive = true;
+      slot.name = entity_name;
+      entity_count++;
+      return slot.id;  //  Return new entity ID.
+    };
+
+    /*!
+     * \brief Make room for more entities.
+     * \param n Number of entities to make room for.
+     */
+    static void reserve(const std::size_t& n) {
+      const std::size_t reused = std::min(n, free_slots.size());
+      slots.reserve(std::max(slots.size(), ENTITY_START) + n - reused);
+      name_index.reserve(entity_count + n);
+    };
+
+    /*!
+     * \brief Make room for more components of a type.
+     *
+     * Reserves both the pool and the memory the components are created in.
+     *
+     * \tparam T Component type to reserve.
+     * \param n Number of components to make room for.
+     */
+    template <typename T>
+    inline static void reserve(const std::size_t& n) {
+      pool<T>().reserve(n, slots.capacity());
+      pool_allocator<T>::reserve(n);
+    };
+
+    /*!
+     * \brief Create a number of entities at once.
+     *
+     * Room for the entities and for components of the listed types is reserved first,
+     * so adding the components afterwards does not need to grow any storage.
+     * Use add_components to give all of the entities a component in one pass.
+     *
+     * \tparam Ts Component types the entities will be given.
+     * \param n Number of entities to create.
+     * \return The new entity IDs.  May hold fewer than requested if IDs run out.
+     */
+    template <typename... Ts>
+    inline static std::vector<entity_id> create_entities(const std::size_t& n) {
+      reserve(n);
+      (reserve<Ts>(n), ...);
+
+      std::vector<entity_id> temp_vec;
+      temp_vec.reserve(n);
+      for (std::size_t i = 0; i < n; i++) {
+        const entity_id e_id = new_entity();
+        if (e_id == ENTITY_ERROR) break;
+        temp_vec.push_back(e_id);
+      }
+      return temp_vec;
     };
 
     /*!
      * \brief Delete entity by ID.
+     *
+     * If called while the world is locked by systems or component containers,
+     * the entity is deleted once the world is unlocked.
+     *
      * \param e_id The entity ID to delete.
      * \return Return true on success, false if entity does not exist.
      */
     static bool delete_entity(const entity_id& e_id) {
-      auto e_it = std::find_if (entity_vec.begin(), entity_vec.end(), [&e_id](const entity& e){ return e.first == e_id; });
-      if (e_it == entity_vec.end()) return false;
+      entity_slot* slot = get_slot(e_id);
+      if (slot == nullptr) return false;
+
+      //  World is locked, delete once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        pending_entities.push_back(e_id);
+        return true;
+      }
 
-      _world.erase(e_id);      //  Remove all associated componenets.
-      entity_vec.erase(e_it);  //  Delete the entity.
+      for (auto& it: _pools) it->remove(e_id);  //  Remove all associated componenets.
+      for (auto& it: _tag_sets) it->remove(e_id);  //  Remove all tags.
+      release_slot(*slot);  //  Delete the entity.
 
       return true;
     };
 
+    /*!
+     * \brief Deactivate an entity.
+     *
+     * The entity keeps its ID and name, but its components and tags are moved out of the world
+     * so no systems or containers see it until it is activated again.
+     * The components are kept in memory and restored as they were.
+     * If called while the world is locked, the entity is deactivated once the world is unlocked.
+     *
+     * \param e_id The entity ID to deactivate.
+     * \return Return true on success, false if the entity does not exist or is already inactive.
+     */
+    static bool deactivate(const entity_id& e_id) {
+      if (!entity_exists(e_id)) return false;
+
+      //  World is locked, deactivate once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        if (!will_be_active(e_id)) return false;
+        pending_activations.push_back(std::make_pair(e_id, false));
+        return true;
+      }
+      if (!will_be_active(e_id)) return false;
+      stash(e_id);
+      return true;
+    };
+
+    /*!
+     * \brief Activate a deactivated entity, returning its components and tags to the world.
+     *
+     * If called while the world is locked, the entity is activated once the world is unlocked.
+     *
+     * \param e_id The entity ID to activate.
+     * \return Return true on success, false if the entity is not deactivated.
+     */
+    static bool activate(const entity_id& e_id) {
+      if (!entity_exists(e_id)) return false;
+
+      //  World is locked, activate once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        if (will_be_active(e_id)) return false;
+        pending_activations.push_back(std::make_pair(e_id, true));
+        return true;
+      }
+      if (will_be_active(e_id)) return false;
+      unstash(e_id);
+      return true;
+    };
+
+    /*!
+     * \brief Check if an entity exists and is active.
+     * \param e_id The entity ID to check.
+     * \return Return true if the entity exists and has not been deactivated.
+     */
+    static bool is_active(const entity_id& e_id) {
+      return (entity_exists(e_id) && stashes.find(e_id) == stashes.end());
+    };
+
     /*!
      * \brief Check if an entity exists by ID.
      * \param e_id The entity ID to check.
      * \return Return true if found, return false if not found.
      */
     static bool entity_exists(const entity_id& e_id) {
-      const bool result = (std::find_if (entity_vec.begin(), entity_vec.end(), [&e_id](const entity& e){ return e.first == e_id; }) != entity_vec.end());
-      return result;
+      return (get_slot(e_id) != nullptr);
     };
 
     /*!
@@ -179,12 +1227,28 @@ class world final : private manager<world> {
      * \exception engine_exception Entity does not exist.
      */
     static const std::string get_name(const entity_id& e_id) {
-      auto e_it = std::find_if (entity_vec.begin(), entity_vec.end(), [&e_id](const entity& e){ return e.first == e_id; });
-      if (e_it == entity_vec.end()) {
+      const entity_slot* slot = get_slot(e_id);
+      if (slot == nullptr) {
         //  Not found, throw error.
         throw engine_exception("Entity " + std::to_string(e_id) + " does not exist", "World", 4);
       }
-      return e_it->second;
+      return slot_name(*slot);
+    };
+
+    /*!
+     * \brief Get entity name as a symbol.
+     * \param e_id Entity ID to get name for.
+     * \return Entity name symbol.
+     * \exception engine_exception Entity does not exist.
+     */
+    static symbol get_symbol(const entity_id& e_id) {
+      const entity_slot* slot = get_slot(e_id);
+      if (slot == nullptr) {
+        //  Not found, throw error.
+        throw engine_exception("Entity " + std::to_string(e_id) + " does not exist", "World", 4);
+      }
+      if (slot->name == 0) return symbols::intern(default_name(entity_index(e_id)));
+      return slot->name;
     };
 
     /*!
@@ -197,13 +1261,18 @@ class world final : private manager<world> {
       const entity_id& e_id,
       const std::string& name
     ) {
-      auto n_it = std::find_if (entity_vec.begin(), entity_vec.end(), [&name](const entity& e){ return e.second == name; });
-      if (n_it != entity_vec.end()) return false;  //  Entity with the new name exists, error.
+      entity_slot* slot = get_slot(e_id);
+      if (slot == nullptr) return false;  //  Didn't find entity_id, error.
 
-      auto e_it = std::find_if (entity_vec.begin(), entity_vec.end(), [&e_id](const entity& e){ return e.first == e_id; });
-      if (e_it == entity_vec.end()) return false;  //  Didn't find entity_id, error.
+      symbol sym;
+      if (symbols::find(name, sym) && name_index.find(sym) != name_index.end())
+        return false;  //  Entity with the new name exists, error.
+      if (default_name_index(name) != 0) return false;  //  Entity with the new default name exists, error.
+      sym = symbols::intern(name);  //  Only keep names that are used.
 
-      e_it->second = name;
+      if (slot->name != 0) name_index.erase(slot->name);
+      name_index.insert(std::make_pair(sym, e_id));
+      slot->name = sym;
       return true;
     };
 
@@ -213,9 +1282,27 @@ class world final : private manager<world> {
      * \return Entity ID, slv_ENTITY_ERROR if not found.
      */
     static entity_id get_id(const std::string& name) {
-      auto n_it = std::find_if (entity_vec.begin(), entity_vec.end(), [&name](const entity& e){ return e.second == name; });
-      if (n_it == entity_vec.end()) return ENTITY_ERROR;
-      return n_it->first;
+      symbol sym;
+      if (symbols::find(name, sym)) {
+        const auto n_it = name_index.find(sym);
+        if (n_it != name_index.end()) return n_it->second;
+      }
+      const std::size_t idx = default_name_index(name);
+      if (idx == 0) return ENTITY_ERROR;
+      return slots[idx].id;
+    };
+
+    /*!
+     * \brief Get entity ID by name symbol.
+     * \param name Name symbol to search.
+     * \return Entity ID, slv_ENTITY_ERROR if not found.
+     */
+    static entity_id get_id(const symbol& name) {
+      const auto n_it = name_index.find(name);
+      if (n_it != name_index.end()) return n_it->second;
+      const std::size_t idx = default_name_index(symbols::str(name));
+      if (idx == 0) return ENTITY_ERROR;
+      return slots[idx].id;
     };
 
     /*!
@@ -223,7 +1310,11 @@ class world final : private manager<world> {
      * \return Returns a vector of all entity IDs and names.
      */
     static const entities get_entities(void) {
-      entities temp_vec = entity_vec;
+      entities temp_vec;
+      temp_vec.reserve(entity_count);
+      for (auto& it: slots) {
+        if (it.alive) temp_vec.push_back(std::make_pair(it.id, slot_name(it)));
+      }
       return temp_vec;
     };
 
@@ -239,10 +1330,9 @@ class world final : private manager<world> {
       }
 
       entity_container temp_container;
-      const auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        temp_container.emplace_back(cmp::component_sptr((*it).second));
+      for (auto& it: _pools) {
+        cmp::component_sptr c = it->at(e_id);
+        if (c) temp_container.emplace_back(std::move(c));
       }
       return temp_container;
     };
@@ -259,16 +1349,21 @@ class world final : private manager<world> {
       }
 
       const_entity_container temp_container;
-      const auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        temp_container.emplace_back(cmp::component_csptr((*it).second));
+      for (auto& it: _pools) {
+        cmp::component_csptr c = it->at(e_id);
+        if (c) temp_container.emplace_back(std::move(c));
       }
       return temp_container;
     };
 
     /*!
      * \brief Add a component to an entity.
+     *
+     * If called while the world is locked by systems or component containers,
+     * the component is created now and added to its pool once the world is unlocked.
+     * Until then it can already be found by has_component, get_component and set_component,
+     * but views and queries do not include it.
+     *
      * \tparam T Component type to add.
      * \param e_id Entity ID to add a component to.
      * \param args List of parameters to pass to component constructor.
@@ -283,20 +1378,60 @@ class world final : private manager<world> {
     ) {
       if (!entity_exists(e_id)) return false;
 
-      //  Check derived types of existing components, make sure one does not already exist.
-      const auto check_entity = get_entity(e_id);
+      //  Make sure a component of the same type does not already exist.
+      auto& p = pool<T>();
+      if (p.contains(e_id)) return false;
 
-      for (auto& it: check_entity) {
-        auto& r = *it.get();
-        if (typeid(r).name() == typeid(T).name()) return false;
+      //  Component and control block share one block from the type's memory pool.
+      std::shared_ptr<T> c = std::allocate_shared<T>(pool_allocator<T>(), args...);
+      c->type = cmp::get_type_id<T>();
+
+      //  World is locked, add once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        if (find_pending_locked<T>(e_id).c != nullptr) return false;
+        push_pending({ &p, e_id, std::move(c) }, true);
+        return true;
       }
+      return p.insert(e_id, std::move(c));
+    };
 
-      _world.insert(std::make_pair(e_id, std::make_shared<T>(args...)));
-      return true;
+    /*!
+     * \brief Add a component of the same type to a number of entities at once.
+     *
+     * Each entity is given its own component constructed from the same arguments.
+     * Storage is grown once and the components are appended to the pool in one pass.
+     * If called while the world is locked, each component is added as by add_component.
+     *
+     * \tparam T Component type to add.
+     * \param e_ids Entity IDs to add a component to.
+     * \param args List of parameters to pass to each component constructor.
+     * \return Number of components added.
+     * Entities that do not exist or already have a component of the type are skipped.
+     */
+    template <typename T, typename... Args>
+    inline static std::size_t add_components(const std::vector<entity_id>& e_ids, Args... args) {
+      if (lock_count > 0) {
+        std::size_t count = 0;
+        for (auto& it: e_ids) if (add_component<T>(it, args...)) count++;
+        return count;
+      }
+
+      pool_allocator<T>::reserve(e_ids.size());
+      return pool<T>().insert_many(e_ids, slots.size(), [&args...](const entity_id& e_id) {
+        if (!entity_exists(e_id)) return std::shared_ptr<T>();
+        std::shared_ptr<T> c = std::allocate_shared<T>(pool_allocator<T>(), args...);
+        c->type = cmp::get_type_id<T>();
+        return c;
+      });
     };
 
     /*!
      * \brief Delete a component by type for an entity.
+     *
+     * If called while the world is locked by systems or component containers,
+     * the component is deleted once the world is unlocked.
+     *
      * \tparam T Component type to delete.
      * \param e_id Entity ID to delete component from.
      * \return Return true if a component was deleted.
@@ -304,13 +1439,23 @@ class world final : private manager<world> {
      */
     template <typename T>
     inline static bool delete_component(const entity_id& e_id) {
-      auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        if (std::dynamic_pointer_cast<T>(it->second)) {
-          it = _world.erase(it);
+      for (auto& it: _pools) {
+        if (!it->contains(e_id) || !holds<T>(it)) continue;
+        //  World is locked, delete once unlocked.
+        if (lock_count > 0) {
+          std::lock_guard<std::mutex> lock(command_mtx);
+          push_pending({ it, e_id, nullptr }, false);
           return true;
         }
+        return it->remove(e_id);
+      }
+      //  Component recorded to be added, delete it after the add.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        component_command added = find_pending_locked<T>(e_id);
+        if (added.c == nullptr) return false;
+        push_pending({ added.pool, e_id, nullptr }, true);
+        return true;
       }
       return false;
     };
@@ -324,17 +1469,14 @@ class world final : private manager<world> {
      */
     template <typename T>
     inline static bool has_component(const entity_id& e_id) {
-      const auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        if (std::dynamic_pointer_cast<T>(it->second))
-          return true;
-      }
-      return false;
+      return (find<T>(e_id) != nullptr);
     };
 
     /*!
      * \brief Set the value of a component by type for an entity.
+     *
+     * The component is marked as changed.
+     *
      * \tparam T Component type to search.
      * \param e_id The entity ID to search.
      * \return Return the component.
@@ -342,18 +1484,42 @@ class world final : private manager<world> {
      */
     template <typename T>
     inline static const std::shared_ptr<T> set_component(const entity_id& e_id) {
-      const auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        if (std::dynamic_pointer_cast<T>(it->second))
-          return std::static_pointer_cast<T>(it->second);
+      std::shared_ptr<T> c = find<T>(e_id);
+      if (c) {
+        //  Mark as changed.  Components still to be added are marked when added.
+        if (component_storage* p = find_pool<T>(e_id)) p->touch(e_id);
+        return c;
       }
 
       throw engine_exception("Entity: " + std::to_string(e_id) + " - Component not found", "World", 4);
     };
 
+    /*!
+     * \brief Mark a component as changed.
+     *
+     * Call after writing to a component through a view or query,
+     * so changed and query_changed see it.
+     * Safe to call from parallel_for_each for the component being worked on.
+     *
+     * \tparam T Component type to mark.
+     * \param e_id The entity ID of the component.
+     * \return True if marked, false if the entity does not have the component.
+     */
+    template <typename T>
+    inline static bool touch(const entity_id& e_id) {
+      component_storage* p = find_pool<T>(e_id);
+      if (p == nullptr) return false;
+      p->touch(e_id);
+      return true;
+    };
+
     /*!
      * \brief Read the value of a component by type for an entity.
+     *
+     * A type that is not final also finds components whose base_type is that type, one level deep.
+     * Component types nothing derives from should be final, so they are looked up directly.
+     * In debug mode, searching by a type that is not final with no derived types registered is logged.
+     *
      * \tparam T Component type to search.
      * \param e_id The entity ID to search.
      * \return Return the component.
@@ -361,46 +1527,313 @@ class world final : private manager<world> {
      */
     template <typename T>
     inline static const std::shared_ptr<const T> get_component(const entity_id& e_id) {
-      const auto results = _world.equal_range(e_id);
-
-      for (auto it = results.first; it != results.second; it++) {
-        if (std::dynamic_pointer_cast<T>(it->second))
-          return std::static_pointer_cast<const T>(it->second);
-      }
+      std::shared_ptr<const T> c = find<T>(e_id);
+      if (c) return c;
 
       throw engine_exception("Entity: " + std::to_string(e_id) + " - Component not found", "World", 4);
     };
 
     /*!
      * \brief Return a 'set' container for all components for a particulair type.
+     *
+     * The container reads the world directly and does not copy the components.
+     * While it is in use, added or removed components and deleted entities are applied once it is released.
+     * Components changed through the container are not marked as changed, use touch.
+     *
      * \tparam T Component type to search.
      * \return Returns a container of components of all the same type.
      */
     template <typename T>
     inline static const component_container<T> set_components(void) {
-      component_container<T> temp_components;
-
-      for (auto& it: _world) {
-        if (std::dynamic_pointer_cast<T>(it.second))
-          temp_components.insert(std::make_pair(it.first, std::static_pointer_cast<T>(it.second)));
-      }
-      return temp_components;
+      if constexpr (std::is_final_v<T>) pool<T>();  //  Make sure the pool is registered.
+      else check_lookup<T>();
+      return component_container<T>();
     };
 
     /*!
      * \brief Return a 'get' container for all components for a particulair type.
+     *
+     * The container reads the world directly and does not copy the components.
+     * While it is in use, added or removed components and deleted entities are applied once it is released.
+     *
      * \tparam T Component type to search.
      * \return Returns a constant container of components of all the same type.
      */
     template <typename T>
     inline static const const_component_container<T> get_components(void) {
-      const_component_container<T> temp_components;
+      if constexpr (std::is_final_v<T>) pool<T>();  //  Make sure the pool is registered.
+      else check_lookup<T>();
+      return const_component_container<T>();
+    };
+
+    /*!
+     * \brief Add a tag to an entity.
+     *
+     * Tags are empty types that mark entities without storing any data.
+     * If called while the world is locked by systems or component containers,
+     * the tag is added once the world is unlocked.
+     *
+     * \tparam T Tag type, must be an empty type.
+     * \param e_id Entity ID to add the tag to.
+     * \return Return false if the entity does not exist or already has the tag.
+     * \return Return true on success.
+     */
+    template <typename T>
+    inline static bool add_tag(const entity_id& e_id) {
+      if (!entity_exists(e_id)) return false;
+      tag_set& t = tags<T>();
+      if (t.contains(e_id)) return false;
+
+      //  World is locked, add once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        pending_tags.push_back({ &t, e_id, true });
+        return true;
+      }
+      return t.insert(e_id);
+    };
+
+    /*!
+     * \brief Remove a tag from an entity.
+     *
+     * If called while the world is locked by systems or component containers,
+     * the tag is removed once the world is unlocked.
+     *
+     * \tparam T Tag type.
+     * \param e_id Entity ID to remove the tag from.
+     * \return Return true if the tag was removed, false if the entity did not have it.
+     */
+    template <typename T>
+    inline static bool remove_tag(const entity_id& e_id) {
+      tag_set& t = tags<T>();
+      if (!t.contains(e_id)) return false;
+
+      //  World is locked, remove once unlocked.
+      if (lock_count > 0) {
+        std::lock_guard<std::mutex> lock(command_mtx);
+        pending_tags.push_back({ &t, e_id, false });
+        return true;
+      }
+      return t.remove(e_id);
+    };
+
+    /*!
+     * \brief Check if an entity has a tag.
+     * \tparam T Tag type.
+     * \param e_id The entity ID to check.
+     * \return Return true if the entity has the tag, false if not.
+     */
+    template <typename T>
+    inline static bool has_tag(const entity_id& e_id) {
+      return tags<T>().contains(e_id);
+    };
 
-      for (auto& it: _world) {
-        if (std::dynamic_pointer_cast<T>(it.second))
-          temp_components.insert(std::make_pair(it.first, std::static_pointer_cast<T>(it.second)));
+    /*!
+     * \brief Return a container of all entities with a tag.
+     *
+     * While it is in use, added or removed components and tags and deleted entities are applied once it is released.
+     *
+     * \tparam T Tag type.
+     * \return Returns a container of entity IDs.
+     */
+    template <typename T>
+    inline static const tag_view tagged(void);
+
+    /*!
+     * \brief Register snapshot functions for a component type.
+     *
+     * Only registered component types are saved in snapshots.
+     * The load function must read back everything the save function wrote,
+     * then add the component to the entity.
+     *
+     * \tparam T Component type.
+     * \param key Unique name for the type, stored in the snapshot.
+     * \param save Function to write a component to a snapshot.
+     * \param load Function to read a component from a snapshot and add it to an entity.
+     * \return True if registered, false if the key is already in use.
+     */
+    template <typename T>
+    inline static bool reg_snapshot(
+      const std::string& key,
+      const std::function<void(const T&, snapshot&)>& save,
+      const std::function<void(const entity_id&, snapshot&)>& load
+    ) {
+      return serializers.insert(std::make_pair(key, serializer{
+        [save](snapshot& snap) {
+          const component_pool<T>& p = pool<T>();
+          std::vector<std::pair<entity_id, const T*>> stashed;
+          for (auto& st: stashes) {
+            for (auto& it: st.second.components)
+              if (it.first == &_components<T>) stashed.emplace_back(st.first, static_cast<const T*>(it.second.get()));
+          }
+          snap.write<std::uint64_t>(p.size() + stashed.size());
+          for (std::size_t pos = 0; pos < p.size(); pos++) {
+            snap.write(p.id_at(pos));
+            save(*static_cast<const T*>(p.ptr_at(pos)), snap);
+          }
+          for (auto& it: stashed) {
+            snap.write(it.first);
+            save(*it.second, snap);
+          }
+        },
+        load,
+        [](const std::size_t& n) { reserve<T>(n); }
+      })).second;
+    };
+
+    /*!
+     * \brief Register a tag type to be saved in snapshots.
+     * \tparam T Tag type.
+     * \param key Unique name for the type, stored in the snapshot.
+     * \return True if registered, false if the key is already in use.
+     */
+    template <typename T>
+    inline static bool reg_snapshot_tag(const std::string& key) {
+      return serializers.insert(std::make_pair(key, serializer{
+        [](snapshot& snap) {
+          std::vector<entity_id> ids = tags<T>().entities();
+          for (auto& st: stashes) {
+            for (auto& it: st.second.tags)
+              if (it == &_tags<T>) ids.push_back(st.first);
+          }
+          snap.write<std::uint64_t>(ids.size());
+          for (auto& it: ids) snap.write(it);
+        },
+        [](const entity_id& e_id, snapshot&) { add_tag<T>(e_id); },
+        [](const std::size_t&) {}
+      })).second;
+    };
+
+    /*!
+     * \brief Save all entities and registered components and tags to a snapshot.
+     *
+     * Changes waiting for the world to unlock are not included.
+     * Deactivated entities are saved with their components and restored deactivated.
+     *
+     * \return The snapshot.
+     */
+    static snapshot save_snapshot(void) {
+      snapshot snap;
+      snap.write(SNAPSHOT_MAGIC);
+      snap.write(SNAPSHOT_VERSION);
+
+      //  Entity slots.
+      snap.write<std::uint64_t>(slots.size());
+      for (auto& it: slots) {
+        snap.write(it.id);
+        //  Zero for a free slot, one for an active entity, two for a deactivated entity.
+        snap.write<std::uint8_t>(!it.alive ? 0 : (stashes.find(it.id) == stashes.end() ? 1 : 2));
+        if (it.alive) snap.write_string(symbols::str(it.name));  //  Empty for a default name.
+      }
+      snap.write<std::uint64_t>(free_slots.size());
+      for (auto& it: free_slots) snap.write<std::uint64_t>(it);
+
+      //  Components, in blocks by type so unknown types can be skipped.
+      snap.write<std::uint32_t>(serializers.size());
+      for (auto& it: serializers) {
+        snap.write_string(it.first);
+        const std::size_t size_pos = snap.size();
+        snap.write<std::uint64_t>(0);  //  Block size, filled in below.
+        it.second.save(snap);
+        snap.write_at<std::uint64_t>(size_pos, snap.size() - size_pos - sizeof(std::uint64_t));
       }
-      return temp_components;
+      return snap;
+    };
+
+    /*!
+     * \brief Replace all entities and components with those from a snapshot.
+     *
+     * Entity IDs and names are restored exactly.
+     * Components and tags of types that were not registered are not restored.
+     * If called while the world is locked, the restore happens once the world is unlocked
+     * and replaces any other changes made until then.
+     * The snapshot is checked when called either way.
+     * If a component fails to load, the world is left as it was.
+     * A restore that happens once the world is unlocked cannot throw,
+     * use last_restore_failed to check it.
+     *
+     * \param snap Snapshot to restore.
+     * \exception engine_exception Snapshot data is not valid.
+     */
+    static void restore_snapshot(const snapshot& snap) {
+      snapshot temp_snapshot = snap;
+      if (lock_count > 0) {
+        check_snapshot(temp_snapshot);
+        std::lock_guard<std::mutex> lock(command_mtx);
+        pending_restore = std::move(temp_snapshot);
+        restore_pending = true;
+        return;
+      }
+      load_snapshot(temp_snapshot);
+    };
+
+    /*!
+     * \brief Check if the last snapshot restore failed.
+     * \return True if the last snapshot failed to load and the world was left as it was.
+     */
+    static bool last_restore_failed(void) {
+      return restore_failed;
+    };
+
+    /*!
+     * \brief Return a container of all entities that have each of the component types.
+     *
+     * Iterating gives the entity ID followed by a reference to each component:
+     * \code
+     * for (auto [e_id, loc, mot]: mgr::world::query<cmp::location, const cmp::motion>()) { ... }
+     * \endcode
+     * Component types are matched exactly, base types are not searched.
+     * Use a const type for read only access.
+     * Components changed through the query are not marked as changed, use touch.
+     * While it is in use, added or removed components and deleted entities are applied once it is released.
+     *
+     * \tparam Ts Component types to search.
+     * \return Returns a container of entities and their components.
+     */
+    template <typename... Ts>
+    inline static const component_query<Ts...> query(void) {
+      return component_query<Ts...>();
+    };
+
+    /*!
+     * \brief Return a container of entities with any of the component types changed since a tick.
+     *
+     * Works the same as query, skipping entities where none of the components changed.
+     * A tick of 0 includes all entities.
+     *
+     * \tparam Ts Component types to search.
+     * \param since Tick returned by an earlier call to mark.
+     * \return Returns a container of entities and their components.
+     */
+    template <typename... Ts>
+    inline static const component_query<Ts...> query_changed(const std::uint64_t& since) {
+      return component_query<Ts...>(since);
+    };
+
+    /*!
+     * \brief Mark the current point for change tracking.
+     *
+     * Components changed after this call are newer than the returned tick.
+     * Components are changed when added, accessed with set_component, or marked with touch.
+     *
+     * \return Tick to pass to changed or query_changed later.
+     */
+    static std::uint64_t mark(void) {
+      return component_storage::change_tick++;
+    };
+
+    /*!
+     * \brief Check if a component changed since a tick.
+     * \tparam T Component type to check.
+     * \param e_id The entity ID to check.
+     * \param since Tick returned by an earlier call to mark.
+     * \return True if the component changed after the tick.
+     * \return False if it did not or the entity does not have the component.
+     */
+    template <typename T>
+    inline static bool changed(const entity_id& e_id, const std::uint64_t& since) {
+      const component_storage* p = find_pool<T>(e_id);
+      return (p != nullptr && p->version(e_id) > since);
     };
 };
 
@@ -408,4 +1841,408 @@ template <> bool manager<world>::initialized = false;
 
 }
 
+namespace slv {
+
+/*!
+ * \class component_view
+ * \brief Iterate over all components of a type stored in the world.
+ *
+ * Components are read in place from their pools, no copies are made.
+ * Each item is a pair of the entity ID and a pointer to its component.
+ * Components are not marked as changed when written through the view, use mgr::world::touch.
+ * Components added or removed and entities deleted while a view exists are applied once all views are released.
+ *
+ * \tparam T Component type.  Use a const type for read only access.
+ */
+template <typename T>
+class component_view final {
+  private:
+    using component_type = std::remove_const_t<T>;
+
+  public:
+    /*!
+     * \typedef std::pair<entity_id, T*> value_type
+     * Entity ID and component pointer.
+     */
+    using value_type = std::pair<entity_id, T*>;
+
+    /*!
+     * \class iterator
+     * \brief Forward iterator over the component pools.
+     */
+    class iterator final {
+      friend class component_view;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::pair<entity_id, T*>;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+      private:
+        iterator(const std::size_t& pl, const std::size_t& p) : pool_pos(pl), pos(p) { seek(); };
+
+        //  Get a pool by position, nullptr once past the last pool.
+        static component_storage* get_pool(const std::size_t& pl) {
+          if constexpr (std::is_final_v<component_type>)
+            return (pl == 0 ? &mgr::world::_components<component_type> : nullptr);
+          else
+            return (pl < mgr::world::_pools.size() ? mgr::world::_pools[pl] : nullptr);
+        };
+
+        //  Move to the next valid component, skipping pools of other types.
+        void seek(void) {
+          for (const component_storage* p = get_pool(pool_pos); p != nullptr; p = get_pool(++pool_pos)) {
+            if (pos < p->size() && (pos > 0 || mgr::world::holds<component_type>(p))) return;
+            pos = 0;
+          }
+        };
+
+        //  Check if past the last component.
+        bool done(void) const {
+          const component_storage* p = get_pool(pool_pos);
+          return (p == nullptr || pos >= p->size());
+        };
+
+        std::size_t pool_pos;  //  Position in the pool list.
+        std::size_t pos;       //  Position in the current pool.
+        mutable value_type current;
+
+      public:
+        //!  Get the current entity ID and component.
+        reference operator*() const {
+          component_storage* p = get_pool(pool_pos);
+          current = std::make_pair(p->id_at(pos), static_cast<T*>(p->ptr_at(pos)));
+          return current;
+        };
+
+        //!  Access the current entity ID and component.
+        pointer operator->() const { return &(**this); };
+
+        //!  Advance to the next component.
+        iterator& operator++() {
+          pos++;
+          seek();
+          return *this;
+        };
+
+        //!  Advance to the next component.
+        iterator operator++(int) {
+          iterator temp = *this;
+          ++(*this);
+          return temp;
+        };
+
+        //!  Compare iterators.
+        bool operator==(const iterator& it) const {
+          if (done() || it.done()) return (done() && it.done());
+          return (pool_pos == it.pool_pos && pos == it.pos);
+        };
+
+        //!  Compare iterators.
+        bool operator!=(const iterator& it) const { return !(*this == it); };
+    };
+
+    component_view() { mgr::world::lock(); };                         //  Lock the world while in use.
+    component_view(const component_view&) { mgr::world::lock(); };    //  Copies hold their own lock.
+    ~component_view() { mgr::world::unlock(); };                      //  Release the world lock.
+    void operator=(component_view const&) = delete;                   //  Delete assignment operator.
+
+    /*!
+     * \brief Get an iterator to the first component.
+     * \return Iterator to the first component.
+     */
+    iterator begin(void) const { return iterator(0, 0); };
+
+    /*!
+     * \brief Get an iterator past the last component.
+     * \return End iterator.
+     */
+    iterator end(void) const { return iterator(std::numeric_limits<std::size_t>::max(), 0); };
+
+    /*!
+     * \brief Count the components.
+     * \return Number of components.
+     */
+    std::size_t size(void) const {
+      if constexpr (std::is_final_v<component_type>)
+        return mgr::world::_components<component_type>.size();
+      std::size_t count = 0;
+      for (auto it = begin(); it != end(); it++) count++;
+      return count;
+    };
+
+    /*!
+     * \brief Check if there are no components.
+     * \return True if empty, false if not.
+     */
+    bool empty(void) const { return (begin() == end()); };
+
+    /*!
+     * \brief Call a function for each component, splitting the work across the job pool.
+     *
+     * The function may run on several threads at once, so it must only change the component it is given.
+     * Structural changes are recorded and applied once the world is unlocked, as in a loop.
+     *
+     * \param func Called with the entity ID and a pointer to the component.
+     * \param grain Most components given to one job.
+     */
+    template <typename F>
+    void parallel_for_each(const F& func, const std::size_t& grain = 1024) const {
+      for (std::size_t pl = 0; component_storage* p = iterator::get_pool(pl); pl++) {
+        if (!mgr::world::holds<component_type>(p)) continue;
+        job_pool::parallel_for(0, p->size(), grain, [p, &func](const std::size_t& b, const std::size_t& e) {
+          for (std::size_t pos = b; pos < e; pos++) func(p->id_at(pos), static_cast<T*>(p->ptr_at(pos)));
+        });
+      }
+    };
+};
+
+/*!
+ * \class component_query
+ * \brief Iterate over all entities that have each of a set of component types.
+ *
+ * Entities are read from the smallest of the component pools and checked against the others.
+ * Each item is a tuple of the entity ID and a reference to each component.
+ * Components are not marked as changed when written through the query, use mgr::world::touch.
+ * When created with a tick, only entities with a component changed after it are included.
+ * Entities can also be filtered by tag with with and without.
+ * Components added or removed and entities deleted while a query exists are applied once all queries and views are released.
+ *
+ * \tparam Ts Component types.  Use const types for read only access.
+ */
+template <typename... Ts>
+class component_query final {
+  static_assert(sizeof...(Ts) > 0, "Query must have at least one component type!");
+
+  private:
+    //  Pool used to find the entities, the smallest of the component pools.
+    static const component_storage* driver(void) {
+      const component_storage* smallest = nullptr;
+      ((smallest = (smallest == nullptr || mgr::world::_components<std::remove_const_t<Ts>>.size() < smallest->size() ?
+        &mgr::world::_components<std::remove_const_t<Ts>> : smallest)), ...);
+      return smallest;
+    };
+
+  public:
+    /*!
+     * \typedef std::tuple<entity_id, Ts&...> value_type
+     * Entity ID and component references.
+     */
+    using value_type = std::tuple<entity_id, Ts&...>;
+
+    /*!
+     * \class iterator
+     * \brief Forward iterator over the matching entities.
+     */
+    class iterator final {
+      friend class component_query;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::tuple<entity_id, Ts&...>;
+        using pointer = void;
+        using reference = value_type;
+
+      private:
+        iterator(const component_query* q, const component_storage* d, const std::size_t& p,
+          const std::size_t& l = std::numeric_limits<std::size_t>::max()) : owner(q), pool(d), pos(p), last(l) { seek(); };
+
+        //  Position the iterator stops at, the end of the pool or of its range.
+        std::size_t limit(void) const { return (pool->size() < last ? pool->size() : last); };
+
+        //  Move to the next entity that has all of the components.
+        void seek(void) {
+          for (; pool != nullptr && pos < limit(); pos++) {
+            e_id = pool->id_at(pos);
+            components = std::make_tuple(mgr::world::_components<std::remove_const_t<Ts>>.get(e_id)...);
+            if (!((std::get<std::remove_const_t<Ts>*>(components) != nullptr) && ...)) continue;
+            if (!owner->tags_match(e_id)) continue;
+            //  Skip entities with no changes after the tick.
+            const std::uint64_t since = owner->since;
+            if (since == 0 || ((mgr::world::_components<std::remove_const_t<Ts>>.version(e_id) > since) || ...)) return;
+          }
+        };
+
+        //  Check if past the last entity.
+        bool done(void) const { return (pool == nullptr || pos >= limit()); };
+
+        const component_query* owner;   //  Query being iterated.
+        const component_storage* pool;  //  Pool the entities are read from.
+        std::size_t pos;                //  Position in the pool.
+        std::size_t last;               //  Stop before this position.
+        entity_id e_id;                 //  Current entity.
+        std::tuple<std::remove_const_t<Ts>*...> components;  //  Current components.
+
+      public:
+        //!  Get the current entity ID and components.
+        reference operator*() const {
+          return value_type(e_id, *std::get<std::remove_const_t<Ts>*>(components)...);
+        };
+
+        //!  Advance to the next entity.
+        iterator& operator++() {
+          pos++;
+          seek();
+          return *this;
+        };
+
+        //!  Advance to the next entity.
+        iterator operator++(int) {
+          iterator temp = *this;
+          ++(*this);
+          return temp;
+        };
+
+        //!  Compare iterators.
+        bool operator==(const iterator& it) const {
+          if (done() || it.done()) return (done() && it.done());
+          return (pool == it.pool && pos == it.pos);
+        };
+
+        //!  Compare iterators.
+        bool operator!=(const iterator& it) const { return !(*this == it); };
+    };
+
+    /*!
+     * \brief Create a query.
+     * \param s Only include entities with a component changed after this tick.  0 for all.
+     */
+    component_query(const std::uint64_t& s = 0) : since(s) {
+      (mgr::world::pool<std::remove_const_t<Ts>>(), ...);  //  Make sure the pools are registered.
+      mgr::world::lock();                                   //  Lock the world while in use.
+    };
+    component_query(const component_query& q) :
+      since(q.since), with_tags(q.with_tags), without_tags(q.without_tags) { mgr::world::lock(); };  //  Copies hold their own lock.
+    ~component_query() { mgr::world::unlock(); };                     //  Release the world lock.
+    void operator=(component_query const&) = delete;                  //  Delete assignment operator.
+
+    /*!
+     * \brief Get an iterator to the first matching entity.
+     * \return Iterator to the first entity.
+     */
+    iterator begin(void) const { return iterator(this, driver(), 0); };
+
+    /*!
+     * \brief Get an iterator past the last matching entity.
+     * \return End iterator.
+     */
+    iterator end(void) const { return iterator(this, nullptr, 0); };
+
+    /*!
+     * \brief Only include entities that have a tag.
+     * \tparam T Tag type.
+     * \return A copy of the query with the filter added.
+     */
+    template <typename T>
+    component_query with(void) const {
+      component_query q(*this);
+      q.with_tags.push_back(&mgr::world::tags<T>());
+      return q;
+    };
+
+    /*!
+     * \brief Only include entities that do not have a tag.
+     * \tparam T Tag type.
+     * \return A copy of the query with the filter added.
+     */
+    template <typename T>
+    component_query without(void) const {
+      component_query q(*this);
+      q.without_tags.push_back(&mgr::world::tags<T>());
+      return q;
+    };
+
+    /*!
+     * \brief Call a function for each matching entity, splitting the work across the job pool.
+     *
+     * The function may run on several threads at once, so it must only change the entity it is given.
+     * Structural changes are recorded and applied once the world is unlocked, as in a loop.
+     *
+     * \param func Called with the entity ID and a reference to each component.
+     * \param grain Most entities from the driving pool given to one job.
+     */
+    template <typename F>
+    void parallel_for_each(const F& func, const std::size_t& grain = 1024) const {
+      const component_storage* d = driver();
+      job_pool::parallel_for(0, d->size(), grain, [this, d, &func](const std::size_t& b, const std::size_t& e) {
+        //  Each job only looks at its own range, other jobs may be changing the entities past it.
+        for (iterator it(this, d, b, e); !it.done(); ++it) std::apply(func, *it);
+      });
+    };
+
+  private:
+    //  Check an entity against the tag filters.
+    bool tags_match(const entity_id& e_id) const {
+      for (auto& it: with_tags) if (!it->contains(e_id)) return false;
+      for (auto& it: without_tags) if (it->contains(e_id)) return false;
+      return true;
+    };
+
+    const std::uint64_t since;                //  Only include entities changed after this tick.
+    std::vector<const tag_set*> with_tags;     //  Tags entities must have.
+    std::vector<const tag_set*> without_tags;  //  Tags entities must not have.
+};
+
+/*!
+ * \class tag_view
+ * \brief Iterate over all entities with a tag.
+ *
+ * Entity IDs are read in place from the tag set, no copies are made.
+ * Changes to the world while a view exists are applied once all views are released.
+ */
+class tag_view final {
+  public:
+    /*!
+     * \typedef std::vector<entity_id>::const_iterator iterator
+     * Iterator over the entity IDs.
+     */
+    using iterator = std::vector<entity_id>::const_iterator;
+
+    /*!
+     * \brief Create a view of a tag set.
+     * \param t Tag set to view.
+     */
+    tag_view(const tag_set& t) : tags(t) { mgr::world::lock(); };    //  Lock the world while in use.
+    tag_view(const tag_view& v) : tags(v.tags) { mgr::world::lock(); };  //  Copies hold their own lock.
+    ~tag_view() { mgr::world::unlock(); };                              //  Release the world lock.
+    void operator=(tag_view const&) = delete;                           //  Delete assignment operator.
+
+    /*!
+     * \brief Get an iterator to the first entity.
+     * \return Iterator to the first entity.
+     */
+    iterator begin(void) const { return tags.entities().begin(); };
+
+    /*!
+     * \brief Get an iterator past the last entity.
+     * \return End iterator.
+     */
+    iterator end(void) const { return tags.entities().end(); };
+
+    /*!
+     * \brief Count the entities.
+     * \return Number of entities.
+     */
+    std::size_t size(void) const { return tags.entities().size(); };
+
+    /*!
+     * \brief Check if there are no entities.
+     * \return True if empty, false if not.
+     */
+    bool empty(void) const { return tags.entities().empty(); };
+
+  private:
+    const tag_set& tags;  //  Tag set being viewed.
+};
+
+template <typename T>
+inline const tag_view mgr::world::tagged(void) {
+  return tag_view(tags<T>());
+};
+
+}
+
 #endif
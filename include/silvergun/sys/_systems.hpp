@@ -12,5 +12,6 @@
 #include "silvergun/sys/collision.hpp"
 #include "silvergun/sys/logic.hpp"
 #include "silvergun/sys/movement.hpp"
+#include "silvergun/sys/transform.hpp"
 
 #endif
@@ -25,9 +25,10 @@ class animate final : public system {
      * \brief Gets all animation components and processes their run members.
      * 
      * The entity must also have the visible component and is set visible to be drawn.
+     * Animations run on the calling thread, since overlay and background animations draw with Allegro.
      */
     void run(void) override {
-      component_container<cmp::gfx::gfx> animation_components = mgr::world::set_components<cmp::gfx::gfx>();
+      const_component_container<cmp::gfx::gfx> animation_components = mgr::world::get_components<cmp::gfx::gfx>();
 
       for (auto& it: animation_components) {
         if (it.second->visible) it.second->animate(it.first);
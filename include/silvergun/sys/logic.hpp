@@ -28,8 +28,8 @@ class logic final : public system {
      */
     void run(void) override {
       //  Find the entities with the input handler component
-      component_container<cmp::ai> ai_components =
-        mgr::world::set_components<cmp::ai>();
+      const_component_container<cmp::ai> ai_components =
+        mgr::world::get_components<cmp::ai>();
 
       //  Process enabled or disabled ai
       for (auto& it: ai_components) {
@@ -9,6 +9,7 @@
 #define SLV_SYS_MOVEMENT_HPP
 
 #include <cmath>
+#include <cstdint>
 
 #include "silvergun/sys/system.hpp"
 
@@ -20,7 +21,10 @@ namespace slv::sys {
  */
 class movement final : public system {
   public:
-    movement() : system("movement") {};
+    movement() : system("movement") {
+      writes<cmp::location>();
+      reads<cmp::motion, cmp::bounding_box>();
+    };
     ~movement() = default;
 
     /*!
@@ -29,29 +33,38 @@ class movement final : public system {
      * Also checks entities are within their bounding boxes.
      */
     void run(void) override {
-      //  Find the entities with a motion component.
-      const_component_container<cmp::motion> vel_components = mgr::world::get_components<cmp::motion>();
-      for (auto& it: vel_components) {
-        cmp::const_comp_ptr<cmp::location> temp_get = mgr::world::get_component<cmp::location>(it.first);
-        cmp::comp_ptr<cmp::location> temp_set = mgr::world::set_component<cmp::location>(it.first);
-
-        temp_set->pos_x += (it.second->x_vel * std::cos(it.second->direction));
-        temp_set->pos_y += (it.second->y_vel * std::sin(it.second->direction));
-      }
-
-      //  Now check all bounding boxes.
-      const_component_container<cmp::bounding_box> bbox_components = mgr::world::get_components<cmp::bounding_box>();
-      for (auto& it: bbox_components) {
-        cmp::const_comp_ptr<cmp::location> temp_get = mgr::world::get_component<cmp::location>(it.first);
-        cmp::comp_ptr<cmp::location> temp_set = mgr::world::set_component<cmp::location>(it.first);
-
-        if (temp_get->pos_x < it.second->min_x) temp_set->pos_x = it.second->min_x;
-        else if (temp_get->pos_x > it.second->max_x) temp_set->pos_x = it.second->max_x;
-
-        if (temp_get->pos_y < it.second->min_y) temp_set->pos_y = it.second->min_y;
-        else if (temp_get->pos_y > it.second->max_y) temp_set->pos_y = it.second->max_y;
-      }
+      //  Find the entities with a location and motion component.
+      //  Only entities that moved are marked as changed.
+      mgr::world::query<cmp::location, const cmp::motion>().parallel_for_each(
+        [](const entity_id& e_id, cmp::location& loc, const cmp::motion& mot) {
+          const float x_move = mot.x_vel * std::cos(mot.direction);
+          const float y_move = mot.y_vel * std::sin(mot.direction);
+          if (x_move == 0.0f && y_move == 0.0f) return;
+          loc.pos_x += x_move;
+          loc.pos_y += y_move;
+          mgr::world::touch<cmp::location>(e_id);
+        });
+
+      //  Now check bounding boxes, skipping entities that have not changed since the last check.
+      mgr::world::query_changed<cmp::location, const cmp::bounding_box>(last_check).parallel_for_each(
+        [](const entity_id& e_id, cmp::location& loc, const cmp::bounding_box& box) {
+          float x = loc.pos_x, y = loc.pos_y;
+          if (x < box.min_x) x = box.min_x;
+          else if (x > box.max_x) x = box.max_x;
+
+          if (y < box.min_y) y = box.min_y;
+          else if (y > box.max_y) y = box.max_y;
+
+          if (x == loc.pos_x && y == loc.pos_y) return;
+          loc.pos_x = x;
+          loc.pos_y = y;
+          mgr::world::touch<cmp::location>(e_id);
+        });
+      last_check = mgr::world::mark();
     };
+
+  private:
+    std::uint64_t last_check = 0;  //  Tick of the last bounding box check.
 };
 
 }
@@ -9,19 +9,67 @@
 #define SLV_SYS_SYSTEM_HPP
 
 #include <string>
+#include <vector>
 #include <memory>
+#include <type_traits>
+#include <cstdint>
 
 #include "silvergun/cmp/_components.hpp"
 #include "silvergun/mgr/messages.hpp"
 #include "silvergun/mgr/world.hpp"
 
+namespace slv::mgr {
+  class systems;
+}
+
 namespace slv::sys {
 
 /*!
  * \class system
  * \brief Interface class for creating Systems.
+ *
+ * Systems that declare the components they read and write can be run at the same time
+ * as other systems they do not conflict with.
+ * Systems that declare nothing are run alone.
  */
 class system {
+  friend class mgr::systems;
+
+  private:
+    //  Get the ID used to check for conflicts.  Components are grouped by their base type.
+    template <typename T>
+    static cmp::component_id access_id(void) {
+      static_assert(std::is_base_of_v<cmp::component, T>, "Type must be a component!");
+      static_assert(!std::is_same_v<std::remove_cv_t<T>, cmp::component>, "Can not declare access to all components!");
+      if constexpr (std::is_same_v<typename T::base_type, cmp::component>) return cmp::get_type_id<T>();
+      else return cmp::get_type_id<typename T::base_type>();
+    };
+
+    //  Check if two systems can not be run at the same time.
+    bool conflicts(const system& other) const {
+      if (!declared || !other.declared) return true;
+      const auto overlap = [](const std::vector<cmp::component_id>& a, const std::vector<cmp::component_id>& b) {
+        for (auto& it: a) for (auto& o_it: b) if (it == o_it) return true;
+        return false;
+      };
+      return (overlap(write_ids, other.write_ids) ||
+              overlap(write_ids, other.read_ids) ||
+              overlap(read_ids, other.write_ids));
+    };
+
+    //  Check if the system runs on a tick.
+    bool due(const std::uint64_t& tick) const {
+      return (enabled && (interval <= 1 || tick % interval == phase));
+    };
+
+    std::size_t type;  //  Type ID of the system, set by the system manager.
+    std::size_t interval = 1;  //  Run every this many ticks.
+    std::size_t phase = 0;     //  Tick within the interval to run on.
+    bool enabled = true;    //  System is run.
+    bool declared = false;  //  Components used have been declared.
+    std::vector<cmp::component_id> read_ids;   //  Components read.
+    std::vector<cmp::component_id> write_ids;  //  Components written.
+
   protected:
     /*!
      * \brief Create a new timed System object.
@@ -29,6 +77,56 @@ class system {
      */
     system(const std::string& n) : name(n) {};
 
+    /*!
+     * \brief Set how often the system runs.
+     *
+     * Call from the constructor, or use set_interval in the system manager.
+     * Systems with the same interval and different phases run on different ticks,
+     * spreading their work out.
+     *
+     * \param i Run every i ticks.  Zero or one runs every tick.
+     * \param p Tick within the interval to run on.
+     */
+    void run_every(const std::size_t& i, const std::size_t& p) {
+      interval = (i == 0 ? 1 : i);
+      phase = p % interval;
+    };
+
+    /*!
+     * \brief Declare component types the system reads.
+     *
+     * Call from the constructor.
+     * Once declared, the system may only use the declared components,
+     * and can run at the same time as other declared systems that do not write what it reads
+     * or read what it writes.
+     * While running it may add and delete components and tags, delete, activate
+     * and deactivate entities, and send messages, as these are applied at the end of the tick.
+     * It must not create entities, set entity names or use the spawner, as those happen right away.
+     *
+     * The built-in movement, transform and colision systems all use cmp::location,
+     * and movement and transform write it, so none of them run at the same time.
+     *
+     * \tparam Ts Component types.
+     */
+    template <typename... Ts>
+    void reads(void) {
+      declared = true;
+      (read_ids.push_back(access_id<Ts>()), ...);
+    };
+
+    /*!
+     * \brief Declare component types the system writes.
+     *
+     * Call from the constructor.  See reads.
+     *
+     * \tparam Ts Component types.
+     */
+    template <typename... Ts>
+    void writes(void) {
+      declared = true;
+      (write_ids.push_back(access_id<Ts>()), ...);
+    };
+
   public:
     virtual ~system() = default;             //  Default virtual destructor.
     system(const system&) = delete;          //  Delete copy constructor.
@@ -0,0 +1,111 @@
+/*
+ * silvergun
+ * --------
+ * By Matthew Evans
+ * See LICENSE.md for copyright information.
+ */
+
+#if !defined(SLV_SYS_TRANSFORM_HPP)
+#define SLV_SYS_TRANSFORM_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+#include "silvergun/sys/system.hpp"
+
+namespace slv::sys {
+
+/*!
+ * \class transform
+ * \brief Moves child entities with their parents.
+ *
+ * Entities with a parent component have their location set to the parent's location plus the offset.
+ * Parents are always updated before their children, so whole hierarchies move in one pass.
+ * Only entities whose parent moved, or whose own parent or location component changed, are updated.
+ * Add after any systems that move entities.
+ */
+class transform final : public system {
+  private:
+    //  Sort the child entities so parents come before their children.
+    void build_order(void) {
+      std::unordered_map<entity_id, entity_id> parents;
+      for (auto [e_id, par]: mgr::world::query<const cmp::parent>())
+        parents.insert(std::make_pair(e_id, par.parent_id));
+
+      //  Depth is the number of parents above an entity.
+      std::unordered_map<entity_id, std::size_t> depths;
+      const auto depth = [&parents, &depths](entity_id e_id) {
+        std::vector<entity_id> path;
+        std::size_t d = 0;
+        //  Walk up until a root or an entity with a known depth.
+        while (true) {
+          if (const auto it = depths.find(e_id); it != depths.end()) { d = it->second; break; }
+          const auto p_it = parents.find(e_id);
+          if (p_it == parents.end()) break;
+          if (path.size() > parents.size()) return std::size_t(0);  //  Cycle, leave unsorted.
+          path.push_back(e_id);
+          e_id = p_it->second;
+        }
+        for (auto it = path.rbegin(); it != path.rend(); it++) depths[*it] = ++d;
+        return d;
+      };
+
+      std::vector<std::pair<std::size_t, entity_id>> sorted;
+      sorted.reserve(parents.size());
+      for (auto& it: parents) sorted.push_back(std::make_pair(depth(it.first), it.first));
+      std::sort(sorted.begin(), sorted.end());
+
+      order.clear();
+      for (auto& it: sorted) order.push_back(it.second);
+    };
+
+    std::vector<entity_id> order;  //  Child entities, parents first.
+    std::size_t child_count = 0;   //  Number of parent components when the order was built.
+    std::uint64_t last_run = 0;    //  Tick of the last update.
+
+  public:
+    transform() : system("transform") {
+      writes<cmp::location>();
+      reads<cmp::parent>();
+    };
+    ~transform() = default;
+
+    /*!
+     * \brief Update the location of all child entities that need it.
+     */
+    void run(void) override {
+      //  Rebuild the order when parent components are added, removed or changed.
+      const auto changed_parents = mgr::world::query_changed<const cmp::parent>(last_run);
+      const std::size_t count = mgr::world::get_components<cmp::parent>().size();
+      if (count != child_count || changed_parents.begin() != changed_parents.end()) {
+        build_order();
+        child_count = count;
+      }
+
+      for (auto& e_id: order) {
+        if (!mgr::world::has_component<cmp::parent>(e_id)) continue;
+        const auto par = mgr::world::get_component<cmp::parent>(e_id);
+        if (!mgr::world::has_component<cmp::location>(par->parent_id) ||
+            !mgr::world::has_component<cmp::location>(e_id)) continue;
+
+        //  Parents are updated first, so a moved parent has a newer location.
+        //  Also update children that were given a new offset or were moved directly.
+        if (!mgr::world::changed<cmp::location>(par->parent_id, last_run) &&
+            !mgr::world::changed<cmp::parent>(e_id, last_run) &&
+            !mgr::world::changed<cmp::location>(e_id, last_run)) continue;
+
+        const auto parent_loc = mgr::world::get_component<cmp::location>(par->parent_id);
+        const auto loc = mgr::world::set_component<cmp::location>(e_id);
+        loc->pos_x = parent_loc->pos_x + par->offset_x;
+        loc->pos_y = parent_loc->pos_y + par->offset_y;
+      }
+      last_run = mgr::world::mark();
+    };
+};
+
+}
+
+#endif